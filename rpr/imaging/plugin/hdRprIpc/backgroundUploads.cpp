@@ -0,0 +1,228 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "backgroundUploads.h"
+#include "payloadStore.h"
+#include "meshSplitter.h"
+
+#include <algorithm>
+#include <chrono>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Writes are mostly bound by serialization and disk, a few threads saturate them
+const unsigned int kMaxWorkers = 4;
+
+template <typename T>
+bool IsReady(std::future<T> const& future) {
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace anonymous
+
+HdRprIpcBackgroundUploads::HdRprIpcBackgroundUploads(HdRprIpcPayloadStore* payloadStore)
+    : m_payloadStore(payloadStore) {
+
+}
+
+HdRprIpcBackgroundUploads::~HdRprIpcBackgroundUploads() {
+    // Split uploads stop after the current part, queued uploads are dropped.
+    // Written files are removed together with the payload directory
+    for (auto& entry : m_uploads) {
+        entry.second.isCanceled->store(true);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_tasksMutex);
+        m_stopWorkers = true;
+    }
+    m_tasksCondition.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    m_tasks.clear();
+    m_uploads.clear();
+    m_canceledUploads.clear();
+}
+
+void HdRprIpcBackgroundUploads::RunWorker() {
+    while (true) {
+        std::packaged_task<Result()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_tasksMutex);
+            m_tasksCondition.wait(lock, [this]() { return m_stopWorkers || !m_tasks.empty(); });
+            if (m_stopWorkers) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void HdRprIpcBackgroundUploads::Push(SdfPath const& id, SdfLayerRefPtr const& layer, size_t maxPartFaces, Prim* prim) {
+    auto isCanceled = std::make_shared<std::atomic<bool>>(false);
+
+    auto writtenParts = std::make_shared<WrittenParts>();
+
+    auto payloadStore = m_payloadStore;
+    std::packaged_task<Result()> task([payloadStore, layer, id, maxPartFaces, isCanceled, writtenParts]() {
+        Result result = {{}, false, false};
+        if (isCanceled->load()) {
+            // Superseded while waiting in the queue
+            return result;
+        }
+
+        HdRprIpcMeshSplitter splitter(layer->GetPrimAtPath(id), maxPartFaces);
+        if (splitter.GetNumParts() <= 1) {
+            result.payloadPaths.push_back(payloadStore->Write(layer));
+            result.isComplete = !result.payloadPaths.back().empty();
+            return result;
+        }
+
+        // Only one part is held in serialized form at a time
+        result.isSplit = true;
+        for (size_t i = 0; i < splitter.GetNumParts(); ++i) {
+            if (isCanceled->load()) {
+                return result;
+            }
+
+            auto payloadPath = payloadStore->Write(splitter.ExtractPart(i));
+            if (payloadPath.empty()) {
+                return result;
+            }
+            result.payloadPaths.push_back(payloadPath);
+
+            std::lock_guard<std::mutex> lock(writtenParts->mutex);
+            writtenParts->payloadPaths.push_back(std::move(payloadPath));
+        }
+
+        result.isComplete = true;
+        return result;
+    });
+    auto result = task.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_tasksMutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_tasksCondition.notify_one();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CancelImpl(id);
+    m_uploads.emplace(id, Upload{std::move(isCanceled), std::move(result), std::move(writtenParts), 0, prim, layer, maxPartFaces});
+    if (m_workers.size() < std::min(kMaxWorkers, std::max(1u, std::thread::hardware_concurrency())) &&
+        m_workers.size() < m_uploads.size()) {
+        m_workers.emplace_back(&HdRprIpcBackgroundUploads::RunWorker, this);
+    }
+}
+
+void HdRprIpcBackgroundUploads::Cancel(SdfPath const& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CancelImpl(id);
+}
+
+void HdRprIpcBackgroundUploads::CancelAll() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_uploads) {
+        entry.second.isCanceled->store(true);
+        m_canceledUploads.push_back(CanceledUpload{std::move(entry.second.result), entry.second.numHandedOverParts});
+        m_stoppedUploads[entry.first] = StoppedUpload{entry.second.layer, entry.second.maxPartFaces, entry.second.prim};
+    }
+    m_uploads.clear();
+}
+
+void HdRprIpcBackgroundUploads::ResumeAll() {
+    std::map<SdfPath, StoppedUpload> stoppedUploads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stoppedUploads.swap(m_stoppedUploads);
+    }
+
+    for (auto& entry : stoppedUploads) {
+        Push(entry.first, entry.second.layer, entry.second.maxPartFaces, entry.second.prim);
+    }
+}
+
+void HdRprIpcBackgroundUploads::CancelImpl(SdfPath const& id) {
+    m_stoppedUploads.erase(id);
+
+    auto it = m_uploads.find(id);
+    if (it != m_uploads.end()) {
+        it->second.isCanceled->store(true);
+        m_canceledUploads.push_back(CanceledUpload{std::move(it->second.result), it->second.numHandedOverParts});
+        m_uploads.erase(it);
+    }
+}
+
+bool HdRprIpcBackgroundUploads::Commit() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto removePayloads = [this](Result const& result, size_t numHandedOverParts) {
+        for (size_t i = numHandedOverParts; i < result.payloadPaths.size(); ++i) {
+            m_payloadStore->Remove(result.payloadPaths[i]);
+        }
+    };
+
+    for (auto it = m_canceledUploads.begin(); it != m_canceledUploads.end();) {
+        if (IsReady(it->result)) {
+            removePayloads(it->result.get(), it->numHandedOverParts);
+            it = m_canceledUploads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    bool anyCompleted = false;
+    for (auto it = m_uploads.begin(); it != m_uploads.end();) {
+        auto& upload = it->second;
+        if (IsReady(upload.result)) {
+            auto result = upload.result.get();
+            if (result.isComplete) {
+                if (result.payloadPaths.size() > upload.numHandedOverParts) {
+                    upload.prim->OnPayloadsWritten(result.payloadPaths, result.isSplit);
+                    anyCompleted = true;
+                }
+            } else {
+                TF_WARN("Failed to write payload of %s", it->first.GetText());
+                removePayloads(result, upload.numHandedOverParts);
+            }
+            it = m_uploads.erase(it);
+            continue;
+        }
+
+        // Parts that are already written are shown while the rest of the mesh is written
+        std::vector<std::string> payloadPaths;
+        {
+            std::lock_guard<std::mutex> lock(upload.writtenParts->mutex);
+            if (upload.writtenParts->payloadPaths.size() > upload.numHandedOverParts) {
+                payloadPaths = upload.writtenParts->payloadPaths;
+            }
+        }
+        if (!payloadPaths.empty()) {
+            upload.numHandedOverParts = payloadPaths.size();
+            upload.prim->OnPayloadsWritten(payloadPaths, true);
+            anyCompleted = true;
+        }
+        ++it;
+    }
+
+    return anyCompleted;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,129 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_BACKGROUND_UPLOADS_H
+#define HDRPR_BACKGROUND_UPLOADS_H
+
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdRprIpcPayloadStore;
+
+/// Writes binary payloads of heavy prims on a small fixed set of background threads,
+/// uploads wait in a queue when all of them are busy.
+/// Finished payloads are handed over to their prims on Commit,
+/// a payload that was superseded by a newer one before it finished is discarded.
+/// Huge meshes are written as a sequence of part payloads (see HdRprIpcMeshSplitter),
+/// every Commit hands over the parts written so far so that the viewer shows them while the rest is written.
+/// A canceled upload stops after the part that is being written, parts that were already handed over
+/// belong to the prim then.
+class HdRprIpcBackgroundUploads {
+public:
+    class Prim {
+    public:
+        virtual ~Prim() = default;
+
+        /// Called with all payloads written so far, \p isSplit is true if they are parts of a split mesh
+        virtual void OnPayloadsWritten(std::vector<std::string> const& payloadPaths, bool isSplit) = 0;
+    };
+
+    HdRprIpcBackgroundUploads(HdRprIpcPayloadStore* payloadStore);
+    ~HdRprIpcBackgroundUploads();
+
+    HdRprIpcBackgroundUploads(const HdRprIpcBackgroundUploads&) = delete;
+    HdRprIpcBackgroundUploads& operator =(const HdRprIpcBackgroundUploads&) = delete;
+
+    /// Starts writing \p layer, it must not be edited afterwards.
+    /// Non zero \p maxPartFaces splits the mesh \p id into parts of at most that many faces
+    void Push(SdfPath const& id, SdfLayerRefPtr const& layer, size_t maxPartFaces, Prim* prim);
+    void Cancel(SdfPath const& id);
+
+    /// Cancels all uploads when rendering is stopped.
+    /// Canceled uploads are kept and started again by ResumeAll
+    void CancelAll();
+    void ResumeAll();
+
+    /// Hands finished payloads and written parts over to their prims.
+    /// Returns true if any payload has been handed over
+    bool Commit();
+
+private:
+    void CancelImpl(SdfPath const& id);
+    void RunWorker();
+
+private:
+    struct Result {
+        std::vector<std::string> payloadPaths;
+        bool isComplete;
+        bool isSplit;
+    };
+
+    // Parts of a split mesh written so far, filled by the worker while Commit hands them over
+    struct WrittenParts {
+        std::mutex mutex;
+        std::vector<std::string> payloadPaths;
+    };
+
+    struct Upload {
+        std::shared_ptr<std::atomic<bool>> isCanceled;
+        std::future<Result> result;
+        std::shared_ptr<WrittenParts> writtenParts;
+        size_t numHandedOverParts;
+        Prim* prim;
+        SdfLayerRefPtr layer;
+        size_t maxPartFaces;
+    };
+
+    struct CanceledUpload {
+        std::future<Result> result;
+        // Leading payloads that belong to the prim and must not be removed
+        size_t numHandedOverParts;
+    };
+
+    struct StoppedUpload {
+        SdfLayerRefPtr layer;
+        size_t maxPartFaces;
+        Prim* prim;
+    };
+
+    HdRprIpcPayloadStore* m_payloadStore;
+
+    std::mutex m_mutex;
+    std::map<SdfPath, Upload> m_uploads;
+    std::vector<CanceledUpload> m_canceledUploads;
+    std::map<SdfPath, StoppedUpload> m_stoppedUploads;
+
+    // Started with the first upload
+    std::vector<std::thread> m_workers;
+    std::mutex m_tasksMutex;
+    std::condition_variable m_tasksCondition;
+    std::deque<std::packaged_task<Result()>> m_tasks;
+    bool m_stopWorkers = false;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_BACKGROUND_UPLOADS_H
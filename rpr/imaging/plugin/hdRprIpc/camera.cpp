@@ -0,0 +1,40 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "camera.h"
+
+#include "pxr/imaging/hd/sceneDelegate.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+HdRprCamera::HdRprCamera(SdfPath const& id) : HdCamera(id) {
+
+}
+
+void HdRprCamera::Sync(HdSceneDelegate* sceneDelegate,
+                       HdRenderParam* renderParam,
+                       HdDirtyBits* dirtyBits) {
+    auto bits = *dirtyBits;
+    HdCamera::Sync(sceneDelegate, renderParam, dirtyBits);
+
+    if (bits & DirtyParams) {
+        auto& id = GetId();
+        m_focalLength = sceneDelegate->GetCameraParamValue(id, UsdGeomTokens->focalLength).GetWithDefault(0.0f);
+        m_fStop = sceneDelegate->GetCameraParamValue(id, UsdGeomTokens->fStop).GetWithDefault(0.0f);
+        m_focusDistance = sceneDelegate->GetCameraParamValue(id, UsdGeomTokens->focusDistance).GetWithDefault(0.0f);
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,45 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_CAMERA_H
+#define HDRPR_CAMERA_H
+
+#include "pxr/imaging/hd/camera.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Stock camera extended with depth of field parameters
+class HdRprCamera final : public HdCamera {
+public:
+    HdRprCamera(SdfPath const& id);
+    ~HdRprCamera() override = default;
+
+    void Sync(HdSceneDelegate* sceneDelegate,
+              HdRenderParam* renderParam,
+              HdDirtyBits* dirtyBits) override;
+
+    float GetFocalLength() const { return m_focalLength; }
+    float GetFStop() const { return m_fStop; }
+    float GetFocusDistance() const { return m_focusDistance; }
+
+private:
+    float m_focalLength = 0.0f;
+    // Zero disables depth of field
+    float m_fStop = 0.0f;
+    float m_focusDistance = 0.0f;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_CAMERA_H
@@ -0,0 +1,83 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "cameraChannel.h"
+#include "layerUtils.h"
+
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/sdf/changeBlock.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    ((viewMatrix, "rpr:viewMatrix"))
+    ((projectionMatrix, "rpr:projectionMatrix"))
+    ((focalLength, "rpr:focalLength"))
+    ((fStop, "rpr:fStop"))
+    ((focusDistance, "rpr:focusDistance"))
+);
+
+HdRprIpcCameraChannel::HdRprIpcCameraChannel(HdRprIpcServer* ipcServer, SdfPath const& viewportPath)
+    : m_ipcServer(ipcServer)
+    , m_path(viewportPath.AppendChild(TfToken("Camera"))) {
+
+}
+
+HdRprIpcCameraChannel::~HdRprIpcCameraChannel() {
+    if (m_layer) {
+        m_ipcServer->RemoveLayer(m_path);
+    }
+}
+
+bool HdRprIpcCameraChannel::Init() {
+    m_layer = m_ipcServer->AddLayer(m_path);
+    if (!m_layer) {
+        return false;
+    }
+
+    auto prim = HdRprIpcDefinePrim(m_layer->GetStage()->GetRootLayer(), m_path, TfToken());
+    m_viewMatrixAttr = HdRprIpcCreateAttribute(prim, _tokens->viewMatrix, SdfValueTypeNames->Matrix4d);
+    m_projectionMatrixAttr = HdRprIpcCreateAttribute(prim, _tokens->projectionMatrix, SdfValueTypeNames->Matrix4d);
+    m_focalLengthAttr = HdRprIpcCreateAttribute(prim, _tokens->focalLength, SdfValueTypeNames->Float);
+    m_fStopAttr = HdRprIpcCreateAttribute(prim, _tokens->fStop, SdfValueTypeNames->Float);
+    m_focusDistanceAttr = HdRprIpcCreateAttribute(prim, _tokens->focusDistance, SdfValueTypeNames->Float);
+    return true;
+}
+
+bool HdRprIpcCameraChannel::Send(HdRprIpcCameraState const& state) {
+    if (m_isSent && m_sentState == state) {
+        return false;
+    }
+
+    if (!m_layer && !Init()) {
+        return true;
+    }
+
+    {
+        SdfChangeBlock changeBlock;
+        HdRprIpcSetAttributeValue(m_viewMatrixAttr, state.viewMatrix);
+        HdRprIpcSetAttributeValue(m_projectionMatrixAttr, state.projectionMatrix);
+        HdRprIpcSetAttributeValue(m_focalLengthAttr, state.focalLength);
+        HdRprIpcSetAttributeValue(m_fStopAttr, state.fStop);
+        HdRprIpcSetAttributeValue(m_focusDistanceAttr, state.focusDistance);
+    }
+    m_ipcServer->OnLayerEdit(m_path, m_layer);
+
+    m_sentState = state;
+    m_isSent = true;
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
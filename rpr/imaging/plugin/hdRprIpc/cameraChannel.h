@@ -0,0 +1,80 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_CAMERA_CHANNEL_H
+#define HDRPR_CAMERA_CHANNEL_H
+
+#include "ipcServer.h"
+
+#include "pxr/base/gf/matrix4d.h"
+#include "pxr/usd/sdf/attributeSpec.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+struct HdRprIpcCameraState {
+    GfMatrix4d viewMatrix = GfMatrix4d(1.0);
+    GfMatrix4d projectionMatrix = GfMatrix4d(1.0);
+    float focalLength = 0.0f;
+    float fStop = 0.0f;
+    float focusDistance = 0.0f;
+
+    bool operator==(HdRprIpcCameraState const& other) const {
+        return viewMatrix == other.viewMatrix &&
+            projectionMatrix == other.projectionMatrix &&
+            focalLength == other.focalLength &&
+            fStop == other.fStop &&
+            focusDistance == other.focusDistance;
+    }
+    bool operator!=(HdRprIpcCameraState const& other) const { return !(*this == other); }
+};
+
+/// Sends camera to the viewer through a dedicated layer with fixed layout.
+/// All specs are created once, an update only replaces attribute values of this small layer
+/// instead of editing the scene layers. It is still sent as a regular layer edit,
+/// how the viewer applies it is up to the viewer.
+/// Updates are coalesced: only the latest state of the primary render pass is sent once per its execution,
+/// see HdRprRenderParam::AcquirePrimaryRenderPass.
+class HdRprIpcCameraChannel {
+public:
+    /// The camera layer is placed under \p viewportPath, every render delegate sends its own camera
+    HdRprIpcCameraChannel(HdRprIpcServer* ipcServer, SdfPath const& viewportPath);
+    ~HdRprIpcCameraChannel();
+
+    HdRprIpcCameraChannel(const HdRprIpcCameraChannel&) = delete;
+    HdRprIpcCameraChannel& operator =(const HdRprIpcCameraChannel&) = delete;
+
+    /// Returns true if \p state differs from the last sent one
+    bool Send(HdRprIpcCameraState const& state);
+
+private:
+    bool Init();
+
+private:
+    HdRprIpcServer* m_ipcServer;
+    SdfPath m_path;
+    RprIpcServer::Layer* m_layer = nullptr;
+
+    SdfAttributeSpecHandle m_viewMatrixAttr;
+    SdfAttributeSpecHandle m_projectionMatrixAttr;
+    SdfAttributeSpecHandle m_focalLengthAttr;
+    SdfAttributeSpecHandle m_fStopAttr;
+    SdfAttributeSpecHandle m_focusDistanceAttr;
+
+    HdRprIpcCameraState m_sentState;
+    bool m_isSent = false;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_CAMERA_CHANNEL_H
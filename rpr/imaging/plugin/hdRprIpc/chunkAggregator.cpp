@@ -0,0 +1,137 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "chunkAggregator.h"
+
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/base/tf/stringUtils.h"
+
+#include <algorithm>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+SdfLayerHandle HdRprIpcChunkAggregator::Chunk::GetLayer() const {
+    return m_layer->GetStage()->GetRootLayer();
+}
+
+HdRprIpcChunkAggregator::HdRprIpcChunkAggregator(HdRprIpcServer* ipcServer)
+    : m_ipcServer(ipcServer)
+    , m_chunksPath("/RprIpc/Chunks") {
+
+}
+
+HdRprIpcChunkAggregator::~HdRprIpcChunkAggregator() {
+    for (auto& chunk : m_chunks) {
+        m_ipcServer->RemoveLayer(chunk->m_path);
+    }
+}
+
+HdRprIpcChunkAggregator::Chunk* HdRprIpcChunkAggregator::AddPrim(SdfPath const& id, size_t maxChunkSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto primIt = m_prims.find(id);
+    if (primIt != m_prims.end()) {
+        primIt->second.numUsers++;
+        return primIt->second.chunk;
+    }
+
+    auto bucketPath = id.GetParentPath();
+    auto& bucket = m_buckets[bucketPath];
+    for (auto chunk : bucket) {
+        if (chunk->m_numPrims < maxChunkSize) {
+            chunk->m_numPrims++;
+            m_prims.emplace(id, PrimState{chunk, 1});
+            return chunk;
+        }
+    }
+
+    auto chunkPath = m_chunksPath.AppendChild(TfToken(TfStringPrintf("chunk%zu", m_chunkCounter++)));
+    auto layer = m_ipcServer->AddLayer(chunkPath);
+    if (!layer) {
+        return nullptr;
+    }
+
+    auto chunk = std::make_unique<Chunk>();
+    chunk->m_path = chunkPath;
+    chunk->m_bucket = bucketPath;
+    chunk->m_layer = layer;
+    chunk->m_numPrims = 1;
+    bucket.push_back(chunk.get());
+    m_prims.emplace(id, PrimState{chunk.get(), 1});
+    m_chunks.push_back(std::move(chunk));
+    return bucket.back();
+}
+
+void HdRprIpcChunkAggregator::RemovePrim(SdfPath const& id) {
+    Chunk* chunk;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto primIt = m_prims.find(id);
+        if (primIt == m_prims.end() || --primIt->second.numUsers > 0) {
+            return;
+        }
+        chunk = primIt->second.chunk;
+        m_prims.erase(primIt);
+    }
+
+    {
+        // The chunk is not released by Commit until its prim count drops below
+        std::lock_guard<std::mutex> chunkLock(chunk->m_mutex);
+
+        if (auto primSpec = chunk->GetLayer()->GetPrimAtPath(id)) {
+            if (auto parent = primSpec->GetRealNameParent()) {
+                parent->RemoveNameChild(primSpec);
+            }
+        }
+        chunk->m_isDirty = true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    chunk->m_numPrims--;
+}
+
+bool HdRprIpcChunkAggregator::HasPrim(SdfPath const& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_prims.count(id) != 0;
+}
+
+void HdRprIpcChunkAggregator::Commit() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+        auto chunk = it->get();
+
+        if (chunk->m_numPrims == 0) {
+            m_ipcServer->RemoveLayer(chunk->m_path);
+
+            auto& bucket = m_buckets[chunk->m_bucket];
+            bucket.erase(std::find(bucket.begin(), bucket.end(), chunk));
+            if (bucket.empty()) {
+                m_buckets.erase(chunk->m_bucket);
+            }
+
+            it = m_chunks.erase(it);
+            continue;
+        }
+
+        if (chunk->m_isDirty) {
+            m_ipcServer->OnLayerEdit(chunk->m_path, chunk->m_layer);
+            chunk->m_isDirty = false;
+        }
+        ++it;
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
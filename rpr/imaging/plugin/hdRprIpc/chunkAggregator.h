@@ -0,0 +1,96 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_CHUNK_AGGREGATOR_H
+#define HDRPR_CHUNK_AGGREGATOR_H
+
+#include "ipcServer.h"
+
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Packs many small prims into shared chunk layers.
+/// Prims are bucketed by their parent path so that a chunk holds siblings,
+/// each bucket is split into chunks of limited size.
+/// Prims mark their chunk dirty on edit and dirty chunks are published
+/// once per sync pass by Commit, so the number of layers and messages
+/// scales with the chunk count rather than the prim count.
+///
+/// Chunks are shared by all render delegates of a session, a prim that several
+/// delegates add is aggregated once and is removed when the last of them removes it.
+class HdRprIpcChunkAggregator {
+public:
+    class Chunk {
+    public:
+        /// Must be held while authoring into the chunk layer
+        std::mutex& GetMutex() { return m_mutex; }
+
+        SdfLayerHandle GetLayer() const;
+
+        void MarkDirty() { m_isDirty = true; }
+
+    private:
+        friend class HdRprIpcChunkAggregator;
+
+        std::mutex m_mutex;
+        SdfPath m_path;
+        SdfPath m_bucket;
+        RprIpcServer::Layer* m_layer = nullptr;
+        size_t m_numPrims = 0;
+        bool m_isDirty = false;
+    };
+
+    HdRprIpcChunkAggregator(HdRprIpcServer* ipcServer);
+    ~HdRprIpcChunkAggregator();
+
+    HdRprIpcChunkAggregator(const HdRprIpcChunkAggregator&) = delete;
+    HdRprIpcChunkAggregator& operator =(const HdRprIpcChunkAggregator&) = delete;
+
+    /// Assigns \p id to a chunk with less than \p maxChunkSize prims.
+    /// Returns the chunk \p id is already assigned to if it has been added before
+    Chunk* AddPrim(SdfPath const& id, size_t maxChunkSize);
+
+    /// Removes prim spec of \p id from its chunk once every AddPrim call has been matched
+    void RemovePrim(SdfPath const& id);
+
+    bool HasPrim(SdfPath const& id);
+
+    /// Publishes dirty chunks and releases empty ones
+    void Commit();
+
+private:
+    HdRprIpcServer* m_ipcServer;
+    SdfPath m_chunksPath;
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    std::map<SdfPath, std::vector<Chunk*>> m_buckets;
+
+    struct PrimState {
+        Chunk* chunk;
+        size_t numUsers;
+    };
+    std::map<SdfPath, PrimState> m_prims;
+    size_t m_chunkCounter = 0;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_CHUNK_AGGREGATOR_H
@@ -0,0 +1,171 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "ipcServer.h"
+
+#include "pxr/base/arch/hash.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/usd/usd/stage.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+const std::string kVersionKey("rprIpc:version");
+
+} // namespace anonymous
+
+uint64_t HdRprIpcServer::GenerateVersionSalt() {
+    std::random_device randomDevice;
+    uint64_t seed[2] = {
+        (uint64_t(randomDevice()) << 32) | randomDevice(),
+        uint64_t(std::chrono::steady_clock::now().time_since_epoch().count())
+    };
+    return ArchHash64(reinterpret_cast<const char*>(seed), sizeof(seed));
+}
+
+RprIpcServer::Layer* HdRprIpcServer::AddLayer(SdfPath const& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_layers.find(path);
+    if (it != m_layers.end()) {
+        it->second.numUsers++;
+        return it->second.layer;
+    }
+
+    auto layer = RprIpcServer::AddLayer(path);
+    if (layer) {
+        auto editTracker = EditTracker::New();
+        layer->GetStage()->GetRootLayer()->SetStateDelegate(editTracker);
+        m_layers.emplace(path, LayerState{layer, 0, 1, std::move(editTracker)});
+    }
+    return layer;
+}
+
+void HdRprIpcServer::OnLayerEdit(SdfPath const& path, Layer* layer) {
+    uint64_t version;
+    TfRefPtr<EditTracker> editTracker;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_layers.find(path);
+        if (it == m_layers.end()) {
+            TF_CODING_ERROR("Layer %s is edited before it is added", path.GetText());
+            return;
+        }
+
+        // E.g. another render delegate of the session has synced a shared prim that is already sent
+        editTracker = it->second.editTracker;
+        if (it->second.version != 0 && !editTracker->IsDirty()) {
+            return;
+        }
+
+        version = m_versionSalt + ++m_versionCounter;
+        it->second.version = version;
+    }
+
+    auto rootLayer = layer->GetStage()->GetRootLayer();
+    auto customLayerData = rootLayer->GetCustomLayerData();
+    customLayerData[kVersionKey] = VtValue(version);
+    rootLayer->SetCustomLayerData(customLayerData);
+    editTracker->MarkClean();
+
+    RprIpcServer::OnLayerEdit(path, layer);
+}
+
+bool HdRprIpcServer::RemoveLayer(SdfPath const& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_layers.find(path);
+    if (it == m_layers.end() || --it->second.numUsers > 0) {
+        return false;
+    }
+
+    m_layers.erase(it);
+    RprIpcServer::RemoveLayer(path);
+    return true;
+}
+
+bool HdRprIpcServer::HasLayer(SdfPath const& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_layers.count(path) != 0;
+}
+
+bool HdRprIpcServer::SetViewerVersions(uint8_t const* payload, size_t payloadSize) {
+    std::map<SdfPath, uint64_t> viewerVersions;
+
+    auto lines = TfStringSplit(std::string(reinterpret_cast<const char*>(payload), payloadSize), "\n");
+    for (auto& line : lines) {
+        if (line.empty()) {
+            continue;
+        }
+
+        auto tokens = TfStringTokenize(line);
+        if (tokens.size() != 2 || !SdfPath::IsValidPathString(tokens[0])) {
+            TF_WARN("Malformed resync entry: %s", line.c_str());
+            return false;
+        }
+
+        errno = 0;
+        char* versionEnd = nullptr;
+        auto version = std::strtoull(tokens[1].c_str(), &versionEnd, 10);
+        if (versionEnd == tokens[1].c_str() || *versionEnd != '\0' || errno == ERANGE) {
+            TF_WARN("Malformed resync entry: %s", line.c_str());
+            return false;
+        }
+        viewerVersions.emplace(SdfPath(tokens[0]), version);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_viewerVersions = std::move(viewerVersions);
+    m_resyncRequested = true;
+    return true;
+}
+
+bool HdRprIpcServer::Commit() {
+    std::vector<std::pair<SdfPath, Layer*>> outdatedLayers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_resyncRequested) {
+            m_resyncRequested = false;
+
+            for (auto& entry : m_layers) {
+                // Layers that were added but never sent are sent by their owners
+                if (entry.second.version == 0) {
+                    continue;
+                }
+
+                auto it = m_viewerVersions.find(entry.first);
+                if (it == m_viewerVersions.end() || it->second != entry.second.version) {
+                    outdatedLayers.emplace_back(entry.first, entry.second.layer);
+                }
+            }
+            m_viewerVersions.clear();
+        }
+    }
+
+    // Resent layers keep their versions, their content did not change
+    for (auto& entry : outdatedLayers) {
+        RprIpcServer::OnLayerEdit(entry.first, entry.second);
+    }
+
+    return !outdatedLayers.empty();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,95 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_IPC_SERVER_H
+#define HDRPR_IPC_SERVER_H
+
+#include "server.h"
+
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/layerStateDelegate.h"
+
+#include <cstdint>
+#include <mutex>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// RprIpcServer that stamps every sent layer with a version.
+/// A restarted viewer reports the versions of layers it still has cached
+/// with the "resync" command and only layers it misses or has outdated are sent again.
+///
+/// Layers are reference counted so that render delegates attached to one session
+/// share layers of the same prims (see HdRprIpcSession). Every render delegate syncs
+/// and edits the shared prims, an edit of a layer that has not changed since it was
+/// last sent is not sent again.
+///
+/// Layer functions intentionally hide the ones of RprIpcServer,
+/// all layers must be added, edited and removed through this class.
+class HdRprIpcServer : public RprIpcServer {
+public:
+    using RprIpcServer::RprIpcServer;
+
+    /// Returns the existing layer if \p path has already been added
+    Layer* AddLayer(SdfPath const& path);
+    /// Sends \p layer unless it is unchanged since it was last sent
+    void OnLayerEdit(SdfPath const& path, Layer* layer);
+    /// Removes the layer once every AddLayer call has been matched.
+    /// Returns true if the layer has been removed, i.e. the caller was its last user
+    bool RemoveLayer(SdfPath const& path);
+    /// Returns true if \p path has been added and not yet removed by all its users
+    bool HasLayer(SdfPath const& path);
+
+    /// Records layer versions reported by the viewer, \p payload holds "<layer path> <version>" lines.
+    /// Returns false if the payload is malformed
+    bool SetViewerVersions(uint8_t const* payload, size_t payloadSize);
+
+    /// Resends layers whose versions do not match the versions reported by the viewer.
+    /// Returns true if any layer has been resent
+    bool Commit();
+
+private:
+    static uint64_t GenerateVersionSalt();
+
+private:
+    /// Records whether the root layer of a sent layer has been edited since it was sent
+    class EditTracker : public SdfSimpleLayerStateDelegate {
+    public:
+        static TfRefPtr<EditTracker> New() { return TfCreateRefPtr(new EditTracker); }
+
+        void MarkClean() { _MarkCurrentStateAsClean(); }
+    };
+
+    struct LayerState {
+        Layer* layer;
+        uint64_t version;
+        size_t numUsers;
+        TfRefPtr<EditTracker> editTracker;
+    };
+
+private:
+    std::mutex m_mutex;
+    std::map<SdfPath, LayerState> m_layers;
+
+    // Salt makes versions of different sessions distinct
+    uint64_t m_versionSalt = GenerateVersionSalt();
+    uint64_t m_versionCounter = 0;
+
+    bool m_resyncRequested = false;
+    std::map<SdfPath, uint64_t> m_viewerVersions;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_IPC_SERVER_H
@@ -0,0 +1,160 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "layerUtils.h"
+
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/usdGeom/tokens.h"
+#include "pxr/base/gf/vec2f.h"
+#include "pxr/base/gf/vec3f.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    ((xformOpTransform, "xformOp:transform"))
+    ((resetXformStack, "!resetXformStack!"))
+);
+
+namespace {
+
+size_t GetArrayMemory(VtValue const& value) {
+    if (value.IsHolding<VtVec3fArray>()) {
+        return value.UncheckedGet<VtVec3fArray>().size() * sizeof(GfVec3f);
+    } else if (value.IsHolding<VtVec2fArray>()) {
+        return value.UncheckedGet<VtVec2fArray>().size() * sizeof(GfVec2f);
+    } else if (value.IsHolding<VtIntArray>()) {
+        return value.UncheckedGet<VtIntArray>().size() * sizeof(int);
+    } else if (value.IsHolding<VtFloatArray>()) {
+        return value.UncheckedGet<VtFloatArray>().size() * sizeof(float);
+    }
+    return 0;
+}
+
+} // namespace anonymous
+
+SdfPrimSpecHandle HdRprIpcDefinePrim(SdfLayerHandle const& layer, SdfPath const& path, TfToken const& typeName) {
+    auto prim = layer->GetPrimAtPath(path);
+    if (!prim) {
+        // SdfCreatePrimInLayer authors missing ancestors as overs. Undefined ancestors are
+        // pruned by the default traversal along with everything below them, so define them
+        SdfPathVector createdAncestors;
+        for (auto ancestor = path.GetParentPath(); ancestor.IsPrimPath() && !layer->GetPrimAtPath(ancestor); ancestor = ancestor.GetParentPath()) {
+            createdAncestors.push_back(ancestor);
+        }
+
+        prim = SdfCreatePrimInLayer(layer, path);
+        if (!prim) {
+            return prim;
+        }
+
+        for (auto& ancestor : createdAncestors) {
+            if (auto ancestorSpec = layer->GetPrimAtPath(ancestor)) {
+                ancestorSpec->SetSpecifier(SdfSpecifierDef);
+            }
+        }
+    }
+
+    prim->SetSpecifier(SdfSpecifierDef);
+    if (prim->GetTypeName() != typeName) {
+        prim->SetTypeName(typeName);
+    }
+    return prim;
+}
+
+SdfAttributeSpecHandle HdRprIpcCreateAttribute(SdfPrimSpecHandle const& prim, TfToken const& name,
+                                               SdfValueTypeName const& typeName,
+                                               SdfVariability variability) {
+    auto attrPath = prim->GetPath().AppendProperty(name);
+    if (auto attr = prim->GetLayer()->GetAttributeAtPath(attrPath)) {
+        return attr;
+    }
+    return SdfAttributeSpec::New(prim, name, typeName, variability);
+}
+
+bool HdRprIpcSetAttributeValue(SdfAttributeSpecHandle const& attr, VtValue const& value) {
+    if (!value.IsEmpty() && attr->GetTypeName().GetType() != value.GetType()) {
+        TF_CODING_ERROR("Value of type %s does not match %s attribute %s", value.GetTypeName().c_str(),
+                        attr->GetTypeName().GetAsToken().GetText(), attr->GetPath().GetText());
+        return false;
+    }
+
+    if (attr->HasInfo(SdfFieldKeys->TimeSamples)) {
+        attr->ClearInfo(SdfFieldKeys->TimeSamples);
+    } else if (attr->GetDefaultValue() == value) {
+        return false;
+    }
+    attr->SetDefaultValue(value);
+    return true;
+}
+
+void HdRprIpcSetAttributeTimeSamples(SdfAttributeSpecHandle const& attr, SdfTimeSampleMap timeSamples) {
+    if (attr->HasDefaultValue()) {
+        attr->ClearDefaultValue();
+    }
+    attr->SetInfo(SdfFieldKeys->TimeSamples, VtValue::Take(timeSamples));
+}
+
+bool HdRprIpcSetRelationshipTarget(SdfPrimSpecHandle const& prim, TfToken const& name, SdfPath const& target) {
+    auto rel = prim->GetLayer()->GetRelationshipAtPath(prim->GetPath().AppendProperty(name));
+    if (target.IsEmpty()) {
+        if (!rel) {
+            return false;
+        }
+        prim->RemoveProperty(rel);
+        return true;
+    }
+
+    if (!rel) {
+        rel = SdfRelationshipSpec::New(prim, name.GetString(), false, SdfVariabilityUniform);
+        if (!rel) {
+            return false;
+        }
+    }
+
+    auto targets = rel->GetTargetPathList().GetExplicitItems();
+    if (targets.size() == 1 && targets[0] == target) {
+        return false;
+    }
+    targets = SdfPathVector{target};
+    return true;
+}
+
+SdfAttributeSpecHandle HdRprIpcCreateTransformAttribute(SdfPrimSpecHandle const& prim, bool isWorldSpace) {
+    auto xformOpOrderValue = isWorldSpace ? VtValue(VtTokenArray{_tokens->resetXformStack, _tokens->xformOpTransform})
+                                          : VtValue(VtTokenArray{_tokens->xformOpTransform});
+
+    auto xformOpOrder = HdRprIpcCreateAttribute(prim, UsdGeomTokens->xformOpOrder, SdfValueTypeNames->TokenArray, SdfVariabilityUniform);
+    if (xformOpOrder->GetDefaultValue() != xformOpOrderValue) {
+        xformOpOrder->SetDefaultValue(xformOpOrderValue);
+    }
+    return HdRprIpcCreateAttribute(prim, _tokens->xformOpTransform, SdfValueTypeNames->Matrix4d);
+}
+
+size_t HdRprIpcGetArraysMemory(SdfPrimSpecHandle const& prim) {
+    size_t memory = 0;
+    for (auto& attr : prim->GetAttributes()) {
+        if (attr->HasDefaultValue()) {
+            memory += GetArrayMemory(attr->GetDefaultValue());
+        }
+        for (double time : attr->GetLayer()->ListTimeSamplesForPath(attr->GetPath())) {
+            VtValue value;
+            if (attr->GetLayer()->QueryTimeSample(attr->GetPath(), time, &value)) {
+                memory += GetArrayMemory(value);
+            }
+        }
+    }
+    return memory;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
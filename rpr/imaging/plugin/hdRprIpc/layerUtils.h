@@ -0,0 +1,88 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_LAYER_UTILS_H
+#define HDRPR_LAYER_UTILS_H
+
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/usd/sdf/attributeSpec.h"
+#include "pxr/usd/sdf/relationshipSpec.h"
+#include "pxr/usd/sdf/types.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/type.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Helpers that author scene description directly into SdfLayer specs.
+/// They avoid UsdStage and schema objects that are too heavy to keep per prim.
+
+SdfPrimSpecHandle HdRprIpcDefinePrim(SdfLayerHandle const& layer, SdfPath const& path, TfToken const& typeName);
+
+/// Returns existing attribute spec or creates a new one
+SdfAttributeSpecHandle HdRprIpcCreateAttribute(SdfPrimSpecHandle const& prim, TfToken const& name,
+                                               SdfValueTypeName const& typeName,
+                                               SdfVariability variability = SdfVariabilityVarying);
+
+/// Replaces default value and time samples of \p attr with \p value.
+/// A value that does not match the type of \p attr is a coding error and is not authored.
+/// Returns true if the value has changed
+bool HdRprIpcSetAttributeValue(SdfAttributeSpecHandle const& attr, VtValue const& value);
+
+/// Typed counterpart of the above for values whose type is known at compile time.
+/// The type is checked against the attribute once per \p T and the current default value
+/// is compared as \p T, an unchanged value is not authored so it does not produce a layer edit.
+/// The write itself still stores a VtValue, SdfLayer boxes every field for change processing.
+/// Values fetched from the scene delegate as VtValue take the generic overload
+template <typename T>
+bool HdRprIpcSetAttributeValue(SdfAttributeSpecHandle const& attr, T const& value) {
+    static const TfType valueType = TfType::Find<T>();
+    if (attr->GetTypeName().GetType() != valueType) {
+        TF_CODING_ERROR("Value of type %s does not match %s attribute %s", valueType.GetTypeName().c_str(),
+                        attr->GetTypeName().GetAsToken().GetText(), attr->GetPath().GetText());
+        return false;
+    }
+
+    auto layer = attr->GetLayer();
+    auto& path = attr->GetPath();
+    if (layer->HasField(path, SdfFieldKeys->TimeSamples)) {
+        layer->EraseField(path, SdfFieldKeys->TimeSamples);
+    } else {
+        T currentValue;
+        if (layer->HasField(path, SdfFieldKeys->Default, &currentValue) && currentValue == value) {
+            return false;
+        }
+    }
+    layer->SetField(path, SdfFieldKeys->Default, value);
+    return true;
+}
+
+/// Replaces default value and time samples of \p attr with \p timeSamples.
+/// The map is moved into the layer, pass a temporary to avoid copying every sample
+void HdRprIpcSetAttributeTimeSamples(SdfAttributeSpecHandle const& attr, SdfTimeSampleMap timeSamples);
+
+/// Sets the only target of \p name relationship, empty \p target removes the relationship.
+/// Returns true if the relationship has changed
+bool HdRprIpcSetRelationshipTarget(SdfPrimSpecHandle const& prim, TfToken const& name, SdfPath const& target);
+
+/// Authors single matrix xform op on \p prim.
+/// World space transforms reset the xform stack so that they do not depend on transforms of parent prims
+SdfAttributeSpecHandle HdRprIpcCreateTransformAttribute(SdfPrimSpecHandle const& prim, bool isWorldSpace = true);
+
+/// Returns amount of memory occupied by array values of \p prim
+size_t HdRprIpcGetArraysMemory(SdfPrimSpecHandle const& prim);
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_LAYER_UTILS_H
@@ -11,26 +11,73 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ************************************************************************/
 
+
 #include "light.h"
 #include "renderParam.h"
-#include "materialAdapter.h"
-#include "primvarUtil.h"
-#include "rprApi.h"
+#include "layerUtils.h"
 
-#include "pxr/base/tf/envSetting.h"
+#include "pxr/base/tf/staticTokens.h"
 #include "pxr/base/gf/rotation.h"
 #include "pxr/imaging/hd/sceneDelegate.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/tokens.h"
 #include "pxr/usd/usdLux/blackbody.h"
 #include "pxr/usd/usdLux/tokens.h"
 #include "pxr/usd/sdf/assetPath.h"
+#include "pxr/usd/sdf/schema.h"
 
-#include "pxr/usdImaging/usdImaging/implicitSurfaceMeshUtils.h"
-#include "pxr/imaging/pxOsd/meshTopology.h"
+#include <cmath>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    (RectLight)
+    (SphereLight)
+    (CylinderLight)
+    (DiskLight)
+    (DistantLight)
+    (Mesh)
+    (shape)
+    ((emissionColor, "rpr:emissionColor"))
+);
+
 namespace {
 
+TfToken const& GetLightTypeName(TfToken const& lightType) {
+    if (lightType == HdPrimTypeTokens->rectLight) {
+        return _tokens->RectLight;
+    } else if (lightType == HdPrimTypeTokens->sphereLight) {
+        return _tokens->SphereLight;
+    } else if (lightType == HdPrimTypeTokens->cylinderLight) {
+        return _tokens->CylinderLight;
+    } else if (lightType == HdPrimTypeTokens->diskLight) {
+        return _tokens->DiskLight;
+    }
+    return _tokens->DistantLight;
+}
+
+/// Authors \p value of light parameter \p name, empty value removes the parameter.
+/// Returns true if the parameter has changed
+bool SetLightParam(SdfPrimSpecHandle const& prim, TfToken const& name, VtValue const& value) {
+    auto attr = prim->GetLayer()->GetAttributeAtPath(prim->GetPath().AppendProperty(name));
+    if (value.IsEmpty()) {
+        if (!attr) {
+            return false;
+        }
+        prim->RemoveProperty(attr);
+        return true;
+    }
+
+    if (!attr) {
+        auto typeName = SdfSchema::GetInstance().FindType(value);
+        if (!typeName) {
+            return false;
+        }
+        attr = HdRprIpcCreateAttribute(prim, name, typeName);
+    }
+    return HdRprIpcSetAttributeValue(attr, value);
+}
+
 float GetDiskLightNormalization(GfMatrix4f const& transform, float radius) {
     const double sx = GfVec3d(transform[0][0], transform[1][0], transform[2][0]).GetLength() * radius;
     const double sy = GfVec3d(transform[0][1], transform[1][1], transform[2][1]).GetLength() * radius;
@@ -117,371 +164,192 @@ float ComputeLightIntensity(float intensity, float exposure) {
 
 } // namespace anonymous
 
-rpr::Shape* HdRprLight::CreateDiskLightMesh(HdRprApi* rprApi) {
-    constexpr uint32_t kDiskVertexCount = 32;
-    constexpr float kRadius = 0.5f;
-
-    VtVec3fArray points;
-    VtIntArray pointIndices;
-    VtVec3fArray normals(1, GfVec3f(0.0f, 0.0f, -1.0f));
-    VtIntArray normalIndices(kDiskVertexCount * 3, 0);
-    VtIntArray vpf(kDiskVertexCount, 3);
-
-    points.reserve(kDiskVertexCount + 1);
-    pointIndices.reserve(kDiskVertexCount * 3);
-
-    const double step = M_PI * 2.0 / kDiskVertexCount;
-    for (int i = 0; i < kDiskVertexCount; ++i) {
-        double angle = step * i;
-        points.push_back(GfVec3f(kRadius * cos(angle), kRadius * sin(angle), 0.0f));
-    }
-    const int centerPointIndex = points.size();
-    points.push_back(GfVec3f(0.0f));
-
-    for (int i = 0; i < kDiskVertexCount; ++i) {
-        pointIndices.push_back(i);
-        pointIndices.push_back((i + 1) % kDiskVertexCount);
-        pointIndices.push_back(centerPointIndex);
-    }
-
-    return rprApi->CreateMesh(points, pointIndices, normals, normalIndices, VtVec2fArray(), VtIntArray(), vpf, HdTokens->rightHanded);
-}
-
-rpr::Shape* HdRprLight::CreateRectLightMesh(HdRprApi* rprApi, bool applyTransform, GfMatrix4f const& transform) {
-    constexpr float kHalfSize = 0.5f;
-    VtVec3fArray points = {
-        GfVec3f(kHalfSize, kHalfSize, 0.0f),
-        GfVec3f(kHalfSize, -kHalfSize, 0.0f),
-        GfVec3f(-kHalfSize, -kHalfSize, 0.0f),
-        GfVec3f(-kHalfSize, kHalfSize, 0.0f),
-    };
-    VtIntArray pointIndices = {
-        0, 1, 2,
-        0, 2, 3
-    };
-    VtIntArray vpf(pointIndices.size() / 3, 3);
-
-    if (applyTransform) {
-        for (auto& position : points) {
-            position = transform.Transform(position);
+float HdRprLight::GetAreaLightNormalization(HdSceneDelegate* sceneDelegate) {
+    if (m_lightType == HdPrimTypeTokens->diskLight ||
+        m_lightType == HdPrimTypeTokens->sphereLight) {
+        float radius = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->radius).Get<float>());
+        if (m_lightType == HdPrimTypeTokens->diskLight) {
+            return GetDiskLightNormalization(m_transform, radius);
+        } else {
+            return GetSphereLightNormalization(m_transform, radius);
         }
+    } else if (m_lightType == HdPrimTypeTokens->rectLight) {
+        float width = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->width).Get<float>());
+        float height = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->height).Get<float>());
+        return GetRectLightNormalization(m_transform, width, height);
+    } else if (m_lightType == HdPrimTypeTokens->cylinderLight) {
+        float radius = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->radius).Get<float>());
+        float length = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->length).Get<float>());
+        return GetCylinderLightNormalization(m_transform, length, radius);
     }
-
-    return rprApi->CreateMesh(points, pointIndices, VtVec3fArray(), VtIntArray(), VtVec2fArray(), VtIntArray(), vpf, HdTokens->rightHanded);
-}
-
-rpr::Shape* HdRprLight::CreateSphereLightMesh(HdRprApi* rprApi) {
-    auto& topology = UsdImagingGetUnitSphereMeshTopology();
-    auto& points = UsdImagingGetUnitSphereMeshPoints();
-
-    return rprApi->CreateMesh(points, topology.GetFaceVertexIndices(), VtVec3fArray(), VtIntArray(), VtVec2fArray(), VtIntArray(), topology.GetFaceVertexCounts(), topology.GetOrientation());
+    return 1.0f;
 }
 
-rpr::Shape* HdRprLight::CreateCylinderLightMesh(HdRprApi* rprApi) {
-    auto& topology = UsdImagingGetUnitCylinderMeshTopology();
-    auto& points = UsdImagingGetUnitCylinderMeshPoints();
-
-    return rprApi->CreateMesh(points, topology.GetFaceVertexIndices(), VtVec3fArray(), VtIntArray(), VtVec2fArray(), VtIntArray(), topology.GetFaceVertexCounts(), topology.GetOrientation());
-}
-
-void HdRprLight::SyncAreaLightGeomParams(AreaLight* light, HdSceneDelegate* sceneDelegate, float* intensity) {
-    bool normalizeIntensity = sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->normalize).Get<bool>();
-
+GfMatrix4f HdRprLight::GetAreaLightLocalTransform(HdSceneDelegate* sceneDelegate) {
     if (m_lightType == HdPrimTypeTokens->diskLight ||
         m_lightType == HdPrimTypeTokens->sphereLight) {
         float radius = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->radius).Get<float>());
-
-        light->localTransform = GfMatrix4f(1.0f).SetScale(GfVec3f(radius * 2.0f));
-
-        if (normalizeIntensity) {
-            if (m_lightType == HdPrimTypeTokens->diskLight) {
-                (*intensity) /= GetDiskLightNormalization(m_transform, radius);
-            } else {
-                (*intensity) /= GetSphereLightNormalization(m_transform, radius);
-            }
-        }
+        return GfMatrix4f(1.0f).SetScale(GfVec3f(radius * 2.0f));
     } else if (m_lightType == HdPrimTypeTokens->rectLight) {
         float width = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->width).Get<float>());
         float height = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->height).Get<float>());
-
-        light->localTransform = GfMatrix4f(1.0f).SetScale(GfVec3f(width, height, 1.0f));
-
-        if (normalizeIntensity) {
-            (*intensity) /= GetRectLightNormalization(m_transform, width, height);
-        }
+        return GfMatrix4f(1.0f).SetScale(GfVec3f(width, height, 1.0f));
     } else if (m_lightType == HdPrimTypeTokens->cylinderLight) {
         float radius = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->radius).Get<float>());
         float length = std::abs(sceneDelegate->GetLightParamValue(GetId(), HdLightTokens->length).Get<float>());
+        return GfMatrix4f(1.0f).SetRotate(GfRotation(GfVec3d(0.0, 1.0, 0.0), 90.0)) * GfMatrix4f(1.0f).SetScale(GfVec3f(length, radius * 2.0f, radius * 2.0f));
+    }
+    return GfMatrix4f(1.0f);
+}
 
-        light->localTransform = GfMatrix4f(1.0f).SetRotate(GfRotation(GfVec3d(0.0, 1.0, 0.0), 90.0)) * GfMatrix4f(1.0f).SetScale(GfVec3f(length, radius * 2.0f, radius * 2.0f));
+bool HdRprLight::SyncShape(HdSceneDelegate* sceneDelegate, HdRprRenderParam* rprRenderParam) {
+    SdfPath const& id = GetId();
 
-        if (normalizeIntensity) {
-            (*intensity) /= GetCylinderLightNormalization(m_transform, length, radius);
-        }
+    bool isShapeDirty = false;
+    for (auto& name : {HdLightTokens->radius, HdLightTokens->width, HdLightTokens->height, HdLightTokens->length, HdLightTokens->treatAsPoint,
+                       UsdLuxTokens->shapingConeAngle, UsdLuxTokens->shapingConeSoftness, UsdLuxTokens->shapingIesFile}) {
+        isShapeDirty |= SetLightParam(m_primSpec, name, sceneDelegate->GetLightParamValue(id, name));
+    }
+    if (!isShapeDirty) {
+        return false;
+    }
+
+    // Spot, IES and point lights are handled by the viewer without geometry
+    m_isAreaLight = true;
+    auto iesFile = sceneDelegate->GetLightParamValue(id, UsdLuxTokens->shapingIesFile);
+    if (iesFile.IsHolding<SdfAssetPath>()) {
+        m_isAreaLight = iesFile.UncheckedGet<SdfAssetPath>().GetResolvedPath().empty();
+    } else if (sceneDelegate->GetLightParamValue(id, UsdLuxTokens->shapingConeAngle).IsHolding<float>() &&
+               sceneDelegate->GetLightParamValue(id, UsdLuxTokens->shapingConeSoftness).IsHolding<float>()) {
+        m_isAreaLight = false;
+    } else if (sceneDelegate->GetLightParamValue(id, UsdLuxTokens->treatAsPoint).GetWithDefault(false)) {
+        m_isAreaLight = false;
     }
-}
 
-void HdRprLight::CreateAreaLightMesh(HdRprApi* rprApi, HdSceneDelegate* sceneDelegate) {
-    auto light = new AreaLight;
+    auto layer = m_primSpec->GetLayer();
+    auto shapePrimPath = id.AppendChild(_tokens->shape);
 
-    if (rprApi->IsArbitraryShapedLightSupported()) {
-        rpr::Shape* mesh = nullptr;
-        if (m_lightType == HdPrimTypeTokens->diskLight) {
-            mesh = CreateDiskLightMesh(rprApi);
-        } else if (m_lightType == HdPrimTypeTokens->rectLight) {
-            mesh = CreateRectLightMesh(rprApi);
-        } else if (m_lightType == HdPrimTypeTokens->cylinderLight) {
-            mesh = CreateCylinderLightMesh(rprApi);
-        } else if (m_lightType == HdPrimTypeTokens->sphereLight) {
-            mesh = CreateSphereLightMesh(rprApi);
-        }
+    SdfPath shapePath;
+    if (m_isAreaLight) {
+        shapePath = rprRenderParam->lightShapes.Get(m_lightType);
+    }
 
-        if (mesh) {
-            light->meshes.push_back(mesh);
-        }
-    } else {
-        if (m_lightType == HdPrimTypeTokens->rectLight) {
-            if (auto mesh = CreateRectLightMesh(rprApi)) {
-                light->meshes.push_back(mesh);
-            }
-        } else if (m_lightType == HdPrimTypeTokens->diskLight) {
-            // Rescale rect so that total emission power equals to emission power of approximated shape (area equality)
-            // pi*(R/2)^2 = a^2 -> a = R * sqrt(pi) / 2
-            if (auto mesh = CreateRectLightMesh(rprApi, true, GfMatrix4f(1.0f).SetScale(GfVec3f(sqrt(M_PI) / 2.0)))) {
-                light->meshes.push_back(mesh);
-            }
-        } else if (m_lightType == HdPrimTypeTokens->sphereLight ||
-                   m_lightType == HdPrimTypeTokens->cylinderLight) {
-            // Approximate sphere and cylinder lights via cube
-            constexpr float kHalfSize = 0.5f;
-
-            GfMatrix4f sideTransforms[6] = {
-                GfMatrix4f(1.0).SetRotate(GfRotation(GfVec3d(1.0, 0.0, 0.0), 90.0)).SetTranslateOnly(GfVec3f(0.0f, kHalfSize, 0.0f)), // top (XZ plane)
-                GfMatrix4f(1.0).SetRotate(GfRotation(GfVec3d(1.0, 0.0, 0.0), -90.0)).SetTranslateOnly(GfVec3f(0.0f, -kHalfSize, 0.0f)), // bottom (XZ plane)
-                GfMatrix4f(1.0).SetRotate(GfRotation(GfVec3d(0.0, 1.0, 0.0), -90.0)).SetTranslateOnly(GfVec3f(kHalfSize, 0.0, 0.0)), // side_0 (ZY plane, front)
-                GfMatrix4f(1.0).SetRotate(GfRotation(GfVec3d(0.0, 1.0, 0.0), 90.0)).SetTranslateOnly(GfVec3f(-kHalfSize, 0.0, 0.0)), // side_1 (ZY plane, back)
-                GfMatrix4f(1.0).SetRotate(GfRotation(GfVec3d(0.0, 1.0, 0.0), 180.0)).SetTranslateOnly(GfVec3f(0.0f, 0.0, kHalfSize)), // side_2 (XY plane, front)
-                GfMatrix4f(1.0).SetTranslateOnly(GfVec3f(0.0f, 0.0, -kHalfSize)), // side_3 (XY plane, back)
-            };
-
-            // Rescale cube so that total emission power equals to emission power of approximated shape (area equality)
-            GfMatrix4f scale(1.0f);
-            if (m_lightType == HdPrimTypeTokens->sphereLight) {
-                // 4*pi*(R/2)^2 = 6*a^2 -> a = R * sqrt(pi/6)
-                scale.SetScale(GfVec3f(sqrt(M_PI / 6.0)));
-            } else {
-                // 2*pi*(R/2)^2+2*pi*(R/2)*L = 6*a^2 -> a = sqrt(pi/6 * (R^2/2+R*L)) = sqrt(pi/6 * 3/2)
-                scale.SetScale(GfVec3f(sqrt(M_PI / 4.0)));
-            }
-
-            for (auto& transform : sideTransforms) {
-                if (auto mesh = CreateRectLightMesh(rprApi, true, transform * scale)) {
-                    light->meshes.push_back(mesh);
-                }
-            }
+    if (shapePath.IsEmpty()) {
+        if (auto shapeSpec = layer->GetPrimAtPath(shapePrimPath)) {
+            m_primSpec->RemoveNameChild(shapeSpec);
         }
+        return true;
     }
 
-    HdRprGeometrySettings geomSettings = {};
+    // Shape meshes are shared between all lights of the same type, only local transform is per light
+    auto shapeSpec = HdRprIpcDefinePrim(layer, shapePrimPath, _tokens->Mesh);
+    shapeSpec->GetReferenceList().GetExplicitItems() = SdfReferenceVector{SdfReference(std::string(), shapePath)};
+
+    auto transformAttr = HdRprIpcCreateTransformAttribute(shapeSpec, false);
+    HdRprIpcSetAttributeValue(transformAttr, GfMatrix4d(GetAreaLightLocalTransform(sceneDelegate)));
 
     // By default, conform to Karma's behavior - lights are invisible but still have an effect on the scene
-    geomSettings.visibilityMask = kVisibleAll;
-    geomSettings.visibilityMask &= ~kVisiblePrimary;
-    geomSettings.visibilityMask &= ~kVisibleShadow;
-    geomSettings.visibilityMask &= ~kVisibleLight;
+    auto visibilityAttr = HdRprIpcCreateAttribute(shapeSpec, UsdGeomTokens->visibility, SdfValueTypeNames->Token);
+    HdRprIpcSetAttributeValue(visibilityAttr, UsdGeomTokens->invisible);
 
-    auto constantPrimvars = sceneDelegate->GetPrimvarDescriptors(GetId(), HdInterpolationConstant);
-    HdRprParseGeometrySettings(sceneDelegate, GetId(), constantPrimvars, &geomSettings);
+    return true;
+}
+
+bool HdRprLight::SyncEmission(HdSceneDelegate* sceneDelegate) {
+    SdfPath const& id = GetId();
+
+    // The prim is typed as UsdLux light, so the schema parameters are authored for any UsdLux-aware consumer
+    bool isEmissionDirty = false;
+    for (auto& name : {UsdLuxTokens->intensity, UsdLuxTokens->exposure, UsdLuxTokens->color, UsdLuxTokens->normalize,
+                       UsdLuxTokens->enableColorTemperature, UsdLuxTokens->colorTemperature}) {
+        isEmissionDirty |= SetLightParam(m_primSpec, name, sceneDelegate->GetLightParamValue(id, name));
+    }
+
+    float intensity = sceneDelegate->GetLightParamValue(id, HdLightTokens->intensity).Get<float>();
+    float exposure = sceneDelegate->GetLightParamValue(id, HdLightTokens->exposure).Get<float>();
+    intensity = ComputeLightIntensity(intensity, exposure);
 
-    for (auto& mesh : light->meshes) {
-        rprApi->SetMeshVisibility(mesh, geomSettings.visibilityMask);
+    GfVec3f color = sceneDelegate->GetLightParamValue(id, HdPrimvarRoleTokens->color).Get<GfVec3f>();
+    if (sceneDelegate->GetLightParamValue(id, HdLightTokens->enableColorTemperature).Get<bool>()) {
+        GfVec3f temperatureColor = UsdLuxBlackbodyTemperatureAsRgb(sceneDelegate->GetLightParamValue(id, HdLightTokens->colorTemperature).Get<float>());
+        color[0] *= temperatureColor[0];
+        color[1] *= temperatureColor[1];
+        color[2] *= temperatureColor[2];
     }
 
-    m_light = light;
+    if (m_isAreaLight && sceneDelegate->GetLightParamValue(id, HdLightTokens->normalize).Get<bool>()) {
+        intensity /= GetAreaLightNormalization(sceneDelegate);
+    }
+
+    // Emission is also resolved here so that the viewer gets a single attribute to update
+    auto emissionColorAttr = HdRprIpcCreateAttribute(m_primSpec, _tokens->emissionColor, SdfValueTypeNames->Color3f);
+    isEmissionDirty |= HdRprIpcSetAttributeValue(emissionColorAttr, GfVec3f(color * intensity));
+    return isEmissionDirty;
 }
 
 void HdRprLight::Sync(HdSceneDelegate* sceneDelegate,
-                          HdRenderParam* renderParam,
-                          HdDirtyBits* dirtyBits) {
+                      HdRenderParam* renderParam,
+                      HdDirtyBits* dirtyBits) {
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
-    auto rprApi = rprRenderParam->AcquireRprApiForEdit();
+    rprRenderParam->BeginSync();
 
     SdfPath const& id = GetId();
     HdDirtyBits bits = *dirtyBits;
 
-    if (bits & DirtyBits::DirtyTransform) {
-        m_transform = GfMatrix4f(sceneDelegate->GetLightParamValue(id, HdLightTokens->transform).Get<GfMatrix4d>());
-    }
-
-    if (bits & DirtyParams) {
-        ReleaseLight(rprApi);
-
-        bool isVisible = sceneDelegate->GetVisible(id);
-        if (!isVisible) {
-            // Invisible light does not produces any emission on a scene.
-            // So we simply keep light primitive empty in that case.
-            // We can do it in such a way because Hydra releases light object
-            // whenever it changed and creates it from scratch
+    if (!m_primSpec) {
+        m_layer = rprRenderParam->ipcServer->AddLayer(id);
+        if (!m_layer) {
             *dirtyBits = DirtyBits::Clean;
             return;
         }
 
-        bool newLight = false;
-        auto iesFile = sceneDelegate->GetLightParamValue(id, UsdLuxTokens->shapingIesFile);
-        if (iesFile.IsHolding<SdfAssetPath>()) {
-            auto& path = iesFile.UncheckedGet<SdfAssetPath>();
-            if (!path.GetResolvedPath().empty()) {
-                if (auto light = rprApi->CreateIESLight(path.GetResolvedPath())) {
-                    m_light = light;
-                    newLight = true;
-                }
-            }
-        } else {
-            auto coneAngle = sceneDelegate->GetLightParamValue(id, UsdLuxTokens->shapingConeAngle);
-            auto coneSoftness = sceneDelegate->GetLightParamValue(id, UsdLuxTokens->shapingConeSoftness);
-            if (coneAngle.IsHolding<float>() && coneSoftness.IsHolding<float>()) {
-                if (auto light = rprApi->CreateSpotLight(coneAngle.UncheckedGet<float>(), coneSoftness.UncheckedGet<float>())) {
-                    m_light = light;
-                    newLight = true;
-                }
-            } else if (sceneDelegate->GetLightParamValue(id, UsdLuxTokens->treatAsPoint).GetWithDefault(false)) {
-                if (auto light = rprApi->CreatePointLight()) {
-                    m_light = light;
-                    newLight = true;
-                }
-            } else {
-                CreateAreaLightMesh(rprApi, sceneDelegate);
-                newLight = true;
-            }
-        }
+        auto layer = m_layer->GetStage()->GetRootLayer();
+        layer->SetDefaultPrim(id.GetNameToken());
+        m_primSpec = HdRprIpcDefinePrim(layer, id, GetLightTypeName(m_lightType));
+    }
 
-        if (m_light.which() == kLightTypeNone) {
-            *dirtyBits = DirtyBits::Clean;
-            return;
-        }
+    bool updateLayer = false;
 
-        float intensity = sceneDelegate->GetLightParamValue(id, HdLightTokens->intensity).Get<float>();
-        float exposure = sceneDelegate->GetLightParamValue(id, HdLightTokens->exposure).Get<float>();
-        intensity = ComputeLightIntensity(intensity, exposure);
+    if (bits & DirtyBits::DirtyTransform) {
+        auto transform = sceneDelegate->GetLightParamValue(id, HdLightTokens->transform).Get<GfMatrix4d>();
+        m_transform = GfMatrix4f(transform);
 
-        GfVec3f color = sceneDelegate->GetLightParamValue(id, HdPrimvarRoleTokens->color).Get<GfVec3f>();
-        if (sceneDelegate->GetLightParamValue(id, HdLightTokens->enableColorTemperature).Get<bool>()) {
-            GfVec3f temperatureColor = UsdLuxBlackbodyTemperatureAsRgb(sceneDelegate->GetLightParamValue(id, HdLightTokens->colorTemperature).Get<float>());
-            color[0] *= temperatureColor[0];
-            color[1] *= temperatureColor[1];
-            color[2] *= temperatureColor[2];
-        }
+        auto transformAttr = HdRprIpcCreateTransformAttribute(m_primSpec);
+        updateLayer |= HdRprIpcSetAttributeValue(transformAttr, transform);
+    }
 
-        if (m_light.which() == kLightTypeArea) {
-            SyncAreaLightGeomParams(BOOST_NS::get<AreaLight*>(m_light), sceneDelegate, &intensity);
-        }
+    if (bits & DirtyParams) {
+        auto visibility = sceneDelegate->GetVisible(id) ? UsdGeomTokens->inherited : UsdGeomTokens->invisible;
+        updateLayer |= SetLightParam(m_primSpec, UsdGeomTokens->visibility, VtValue(visibility));
 
-        auto emissionColor = color * intensity;
-        bool isEmissionColorDirty = newLight || m_emisionColor != emissionColor;
-        if (isEmissionColorDirty) { m_emisionColor = emissionColor; }
-
-        struct LightParameterSetter : public BOOST_NS::static_visitor<void> {
-            HdRprApi* rprApi;
-            GfVec3f const& emissionColor;
-            bool emissionColorIsDirty;
-
-            LightParameterSetter(HdRprApi* rprApi, GfVec3f const& emissionColor, bool emissionColorIsDirty)
-                : rprApi(rprApi), emissionColor(emissionColor), emissionColorIsDirty(emissionColorIsDirty) {
-
-            }
-
-            void operator()(LightVariantEmpty) const { /*no-op*/ }
-            void operator()(AreaLight* light) const {
-                if (emissionColorIsDirty || !light->material) {
-                    if (light->material) {
-                        rprApi->ReleaseGeometryLightMaterial(light->material);
-                    }
-                    light->material = rprApi->CreateGeometryLightMaterial(emissionColor);
-                }
-
-                if (light->material) {
-                    for (auto& mesh : light->meshes) {
-                        rprApi->SetMeshMaterial(mesh, light->material, false, false);
-                    }
-                }
-            }
-
-            void operator()(rpr::SpotLight* light) const {
-                if (emissionColorIsDirty) { rprApi->SetLightColor(light, emissionColor); }
-            }
-
-            void operator()(rpr::PointLight* light) const {
-                if (emissionColorIsDirty) { rprApi->SetLightColor(light, emissionColor); }
-            }
-
-            void operator()(rpr::IESLight* light) const {
-                if (emissionColorIsDirty) { rprApi->SetLightColor(light, emissionColor); }
-            }
-        };
-
-        BOOST_NS::apply_visitor(LightParameterSetter{rprApi, emissionColor, isEmissionColorDirty}, m_light);
+        // Intensity, exposure and color are scrubbed interactively,
+        // the shape is resent only when its own parameters change
+        updateLayer |= SyncShape(sceneDelegate, rprRenderParam);
     }
 
     if (bits & (DirtyTransform | DirtyParams)) {
-        struct LightTransformSetter : public BOOST_NS::static_visitor<> {
-            HdRprApi* rprApi;
-            GfMatrix4f const& transform;
-
-            LightTransformSetter(HdRprApi* rprApi, GfMatrix4f const& transform)
-                : rprApi(rprApi), transform(transform) {
-
-            }
-
-            void operator()(LightVariantEmpty) const {}
-            void operator()(AreaLight* light) const {
-                auto modelTransform = light->localTransform * transform;
-                for (auto& mesh : light->meshes) {
-                    rprApi->SetTransform(mesh, modelTransform);
-                }
-            }
-            void operator()(rpr::PointLight* light) const { rprApi->SetTransform(light, transform); }
-            void operator()(rpr::SpotLight* light) const { rprApi->SetTransform(light, transform); }
-            void operator()(rpr::IESLight* light) const { rprApi->SetTransform(light, transform); }
-        };
-        BOOST_NS::apply_visitor(LightTransformSetter{rprApi, m_transform}, m_light);
+        // Normalization of area lights depends on both the shape and the transform
+        updateLayer |= SyncEmission(sceneDelegate);
+    }
+
+    if (updateLayer) {
+        rprRenderParam->ipcServer->OnLayerEdit(id, m_layer);
     }
 
     *dirtyBits = DirtyBits::Clean;
 }
 
-
 HdDirtyBits HdRprLight::GetInitialDirtyBitsMask() const {
     return DirtyBits::DirtyTransform
          | DirtyBits::DirtyParams;
 }
 
-void HdRprLight::ReleaseLight(HdRprApi* rprApi) {
-    struct LightReleaser : public BOOST_NS::static_visitor<> {
-        HdRprApi* rprApi;
-
-        LightReleaser(HdRprApi* rprApi) : rprApi(rprApi) {}
-
-        void operator()(LightVariantEmpty) const { /*no-op*/ }
-        void operator()(rpr::PointLight* light) const { rprApi->Release(light); }
-        void operator()(rpr::SpotLight* light) const { rprApi->Release(light); }
-        void operator()(rpr::IESLight* light) const { rprApi->Release(light); }
-
-        void operator()(AreaLight* light) const {
-            for (auto& mesh : light->meshes) {
-                rprApi->Release(mesh);
-            }
-            rprApi->ReleaseGeometryLightMaterial(light->material);
-            delete light;
-        }
-    };
-
-    BOOST_NS::apply_visitor(LightReleaser{rprApi}, m_light);
-    m_light = LightVariantEmpty{};
-}
-
 void HdRprLight::Finalize(HdRenderParam* renderParam) {
-    auto rprApi = static_cast<HdRprRenderParam*>(renderParam)->AcquireRprApiForEdit();
-    ReleaseLight(rprApi);
+    if (m_layer) {
+        static_cast<HdRprRenderParam*>(renderParam)->ipcServer->RemoveLayer(GetId());
+        m_layer = nullptr;
+        m_primSpec = SdfPrimSpecHandle();
+    }
 
     HdLight::Finalize(renderParam);
 }
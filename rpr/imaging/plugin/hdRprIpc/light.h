@@ -11,22 +11,19 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ************************************************************************/
 
+
 #ifndef HDRPR_LIGHT_H
 #define HDRPR_LIGHT_H
 
-#include "pxr/base/gf/vec3f.h"
+#include "server.h"
+
 #include "pxr/base/gf/matrix4f.h"
 #include "pxr/imaging/hd/light.h"
-
-#include "boostIncludePath.h"
-#include BOOST_INCLUDE_PATH(variant.hpp)
-
-namespace rpr { class Shape; class PointLight; class SpotLight; class IESLight; }
+#include "pxr/usd/sdf/primSpec.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
-class HdRprApi;
-struct HdRprApiMaterial;
+class HdRprRenderParam;
 
 class HdRprLight : public HdLight {
 public:
@@ -46,40 +43,19 @@ public:
     void Finalize(HdRenderParam* renderParam) override;
 
 private:
-    void CreateIESLight(HdRprApi* rprApi, std::string const& path);
+    bool SyncShape(HdSceneDelegate* sceneDelegate, HdRprRenderParam* rprRenderParam);
+    bool SyncEmission(HdSceneDelegate* sceneDelegate);
 
-    void CreateAreaLightMesh(HdRprApi* rprApi, HdSceneDelegate* sceneDelegate);
-    rpr::Shape* CreateDiskLightMesh(HdRprApi* rprApi);
-    rpr::Shape* CreateRectLightMesh(HdRprApi* rprApi, bool applyTransform = false, GfMatrix4f const& transform = GfMatrix4f(1.0f));
-    rpr::Shape* CreateSphereLightMesh(HdRprApi* rprApi);
-    rpr::Shape* CreateCylinderLightMesh(HdRprApi* rprApi);
-
-    struct AreaLight;
-    void SyncAreaLightGeomParams(AreaLight* light, HdSceneDelegate* sceneDelegate, float* intensity);
-
-    void ReleaseLight(HdRprApi* rprApi);
+    float GetAreaLightNormalization(HdSceneDelegate* sceneDelegate);
+    GfMatrix4f GetAreaLightLocalTransform(HdSceneDelegate* sceneDelegate);
 
 private:
     const TfToken m_lightType;
 
-    struct AreaLight {
-        HdRprApiMaterial* material = nullptr;
-        std::vector<rpr::Shape*> meshes;
-        GfMatrix4f localTransform;
-    };
-
-    struct LightVariantEmpty {};
-    using Light = BOOST_NS::variant<LightVariantEmpty, rpr::PointLight*, rpr::SpotLight*, rpr::IESLight*, AreaLight*>;
-    enum LightType {
-        kLightTypeNone,
-        kLightTypePoint,
-        kLightTypeSpot,
-        kLightIES,
-        kLightTypeArea
-    };
-    Light m_light;
-
-    GfVec3f m_emisionColor = GfVec3f(0.0f);
+    RprIpcServer::Layer* m_layer = nullptr;
+    SdfPrimSpecHandle m_primSpec;
+
+    bool m_isAreaLight = false;
     GfMatrix4f m_transform;
 };
 
@@ -0,0 +1,164 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "lightShapes.h"
+#include "layerUtils.h"
+
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/imaging/hd/tokens.h"
+#include "pxr/imaging/pxOsd/meshTopology.h"
+#include "pxr/imaging/pxOsd/tokens.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/tokens.h"
+#include "pxr/usdImaging/usdImaging/implicitSurfaceMeshUtils.h"
+
+#include <cmath>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    (Mesh)
+);
+
+namespace {
+
+const SdfPath kLightShapesPath("/RprIpc/LightShapes");
+
+struct ShapeMesh {
+    VtVec3fArray points;
+    VtIntArray faceVertexCounts;
+    VtIntArray faceVertexIndices;
+    TfToken orientation = UsdGeomTokens->rightHanded;
+};
+
+ShapeMesh CreateDiskLightMesh() {
+    constexpr int kDiskVertexCount = 32;
+    constexpr float kRadius = 0.5f;
+
+    ShapeMesh mesh;
+    mesh.points.reserve(kDiskVertexCount + 1);
+    mesh.faceVertexIndices.reserve(kDiskVertexCount * 3);
+
+    const double step = M_PI * 2.0 / kDiskVertexCount;
+    for (int i = 0; i < kDiskVertexCount; ++i) {
+        double angle = step * i;
+        mesh.points.push_back(GfVec3f(kRadius * cos(angle), kRadius * sin(angle), 0.0f));
+    }
+    const int centerPointIndex = mesh.points.size();
+    mesh.points.push_back(GfVec3f(0.0f));
+
+    for (int i = 0; i < kDiskVertexCount; ++i) {
+        mesh.faceVertexIndices.push_back(i);
+        mesh.faceVertexIndices.push_back((i + 1) % kDiskVertexCount);
+        mesh.faceVertexIndices.push_back(centerPointIndex);
+    }
+    mesh.faceVertexCounts = VtIntArray(kDiskVertexCount, 3);
+
+    return mesh;
+}
+
+ShapeMesh CreateRectLightMesh() {
+    constexpr float kHalfSize = 0.5f;
+
+    ShapeMesh mesh;
+    mesh.points = {
+        GfVec3f(kHalfSize, kHalfSize, 0.0f),
+        GfVec3f(kHalfSize, -kHalfSize, 0.0f),
+        GfVec3f(-kHalfSize, -kHalfSize, 0.0f),
+        GfVec3f(-kHalfSize, kHalfSize, 0.0f),
+    };
+    mesh.faceVertexIndices = {
+        0, 1, 2,
+        0, 2, 3
+    };
+    mesh.faceVertexCounts = VtIntArray(mesh.faceVertexIndices.size() / 3, 3);
+
+    return mesh;
+}
+
+ShapeMesh CreateImplicitSurfaceMesh(PxOsdMeshTopology const& topology, VtVec3fArray const& points) {
+    ShapeMesh mesh;
+    mesh.points = points;
+    mesh.faceVertexCounts = topology.GetFaceVertexCounts();
+    mesh.faceVertexIndices = topology.GetFaceVertexIndices();
+    mesh.orientation = topology.GetOrientation();
+    return mesh;
+}
+
+bool CreateShapeMesh(TfToken const& lightType, ShapeMesh* mesh) {
+    if (lightType == HdPrimTypeTokens->diskLight) {
+        *mesh = CreateDiskLightMesh();
+    } else if (lightType == HdPrimTypeTokens->rectLight) {
+        *mesh = CreateRectLightMesh();
+    } else if (lightType == HdPrimTypeTokens->sphereLight) {
+        *mesh = CreateImplicitSurfaceMesh(UsdImagingGetUnitSphereMeshTopology(), UsdImagingGetUnitSphereMeshPoints());
+    } else if (lightType == HdPrimTypeTokens->cylinderLight) {
+        *mesh = CreateImplicitSurfaceMesh(UsdImagingGetUnitCylinderMeshTopology(), UsdImagingGetUnitCylinderMeshPoints());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace anonymous
+
+HdRprIpcLightShapes::HdRprIpcLightShapes(HdRprIpcServer* ipcServer)
+    : m_ipcServer(ipcServer) {
+
+}
+
+SdfPath HdRprIpcLightShapes::Get(TfToken const& lightType) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_shapes.find(lightType);
+    if (it != m_shapes.end()) {
+        return it->second;
+    }
+
+    ShapeMesh mesh;
+    if (!CreateShapeMesh(lightType, &mesh)) {
+        return SdfPath();
+    }
+
+    auto shapePath = kLightShapesPath.AppendChild(lightType);
+    auto layer = m_ipcServer->AddLayer(shapePath);
+    if (!layer) {
+        return SdfPath();
+    }
+
+    auto meshSpec = HdRprIpcDefinePrim(layer->GetStage()->GetRootLayer(), shapePath, _tokens->Mesh);
+
+    auto pointsAttr = HdRprIpcCreateAttribute(meshSpec, UsdGeomTokens->points, SdfValueTypeNames->Point3fArray);
+    HdRprIpcSetAttributeValue(pointsAttr, mesh.points);
+
+    auto faceVertexCountsAttr = HdRprIpcCreateAttribute(meshSpec, UsdGeomTokens->faceVertexCounts, SdfValueTypeNames->IntArray);
+    HdRprIpcSetAttributeValue(faceVertexCountsAttr, mesh.faceVertexCounts);
+
+    auto faceVertexIndicesAttr = HdRprIpcCreateAttribute(meshSpec, UsdGeomTokens->faceVertexIndices, SdfValueTypeNames->IntArray);
+    HdRprIpcSetAttributeValue(faceVertexIndicesAttr, mesh.faceVertexIndices);
+
+    auto orientationAttr = HdRprIpcCreateAttribute(meshSpec, UsdGeomTokens->orientation, SdfValueTypeNames->Token, SdfVariabilityUniform);
+    HdRprIpcSetAttributeValue(orientationAttr, mesh.orientation);
+
+    auto subdivisionSchemeAttr = HdRprIpcCreateAttribute(meshSpec, UsdGeomTokens->subdivisionScheme, SdfValueTypeNames->Token, SdfVariabilityUniform);
+    HdRprIpcSetAttributeValue(subdivisionSchemeAttr, PxOsdOpenSubdivTokens->none);
+
+    m_ipcServer->OnLayerEdit(shapePath, layer);
+
+    m_shapes.emplace(lightType, shapePath);
+    return shapePath;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,50 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_LIGHT_SHAPES_H
+#define HDRPR_LIGHT_SHAPES_H
+
+#include "ipcServer.h"
+
+#include "pxr/usd/sdf/path.h"
+
+#include <mutex>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Unit shape meshes of area lights.
+/// Each shape is generated and sent once per light type, lights reference
+/// the shared shape and scale it with their local transform.
+class HdRprIpcLightShapes {
+public:
+    HdRprIpcLightShapes(HdRprIpcServer* ipcServer);
+    ~HdRprIpcLightShapes() = default;
+
+    HdRprIpcLightShapes(const HdRprIpcLightShapes&) = delete;
+    HdRprIpcLightShapes& operator =(const HdRprIpcLightShapes&) = delete;
+
+    /// Returns path of the unit shape of \p lightType or an empty path if the light has no shape
+    SdfPath Get(TfToken const& lightType);
+
+private:
+    HdRprIpcServer* m_ipcServer;
+
+    std::mutex m_mutex;
+    std::map<TfToken, SdfPath> m_shapes;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_LIGHT_SHAPES_H
@@ -12,66 +12,45 @@ limitations under the License.
 ************************************************************************/
 
 #include "material.h"
-#include "materialAdapter.h"
-
 #include "renderParam.h"
-#include "rprApi.h"
 
-#include "pxr/usd/sdf/assetPath.h"
+#include "pxr/base/tf/staticTokens.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 TF_DEFINE_PRIVATE_TOKENS(_tokens,
-    ((infoSourceAsset, "info:sourceAsset")) \
-    ((infoImplementationSource, "info:implementationSource")) \
-    (sourceAsset)
+    (UsdPrimvarReader_float2)
+    (varname)
+    (st)
 );
 
-static bool GetMaterialNetwork(
-    TfToken const& terminal, HdSceneDelegate* delegate, HdMaterialNetworkMap const& networkMap, HdRprRenderParam const& renderParam,
-    EMaterialType* out_materialType, HdMaterialNetwork const** out_network) {
-    auto mapIt = networkMap.map.find(terminal);
-    if (mapIt == networkMap.map.end()) {
-        return false;
-    }
+namespace {
 
-    auto& network = mapIt->second;
-    if (network.nodes.empty()) {
-        return false;
-    }
+TfToken GetStName(HdMaterialNetworkMap const& networkMap) {
+    for (auto& entry : networkMap.map) {
+        for (auto& node : entry.second.nodes) {
+            if (node.identifier != _tokens->UsdPrimvarReader_float2) {
+                continue;
+            }
 
-    *out_network = &network;
+            auto varnameIt = node.parameters.find(_tokens->varname);
+            if (varnameIt == node.parameters.end()) {
+                continue;
+            }
 
-    for (auto& node : network.nodes) {
-        if (node.identifier == HdRprMaterialTokens->UsdPreviewSurface) {
-            *out_materialType = EMaterialType::USD_PREVIEW_SURFACE;
-            return true;
-        } else {
-            if (renderParam.GetMaterialNetworkSelector() == HdRprMaterialNetworkSelectorTokens->karma) {
-                auto implementationSource = delegate->Get(node.path, _tokens->infoImplementationSource);
-                if (implementationSource.IsHolding<TfToken>() &&
-                    implementationSource.UncheckedGet<TfToken>() == _tokens->sourceAsset) {
-                    auto nodeAsset = delegate->Get(node.path, _tokens->infoSourceAsset);
-                    if (nodeAsset.IsHolding<SdfAssetPath>()) {
-                        auto& asset = nodeAsset.UncheckedGet<SdfAssetPath>();
-                        if (!asset.GetAssetPath().empty()) {
-                            static const std::string kPrincipledShaderDef = "opdef:/Vop/principledshader::2.0";
-                            if (asset.GetAssetPath().compare(0, kPrincipledShaderDef.size(), kPrincipledShaderDef.c_str())) {
-                                return false;
-                            }
-
-                            *out_materialType = EMaterialType::HOUDINI_PRINCIPLED_SHADER;
-                            return true;
-                        }
-                    }
-                }
+            auto& varname = varnameIt->second;
+            if (varname.IsHolding<TfToken>()) {
+                return varname.UncheckedGet<TfToken>();
+            } else if (varname.IsHolding<std::string>()) {
+                return TfToken(varname.UncheckedGet<std::string>());
             }
         }
     }
-
-    return false;
+    return _tokens->st;
 }
 
+} // namespace anonymous
+
 HdRprMaterial::HdRprMaterial(SdfPath const& id) : HdMaterial(id) {
 
 }
@@ -79,34 +58,27 @@ HdRprMaterial::HdRprMaterial(SdfPath const& id) : HdMaterial(id) {
 void HdRprMaterial::Sync(HdSceneDelegate* sceneDelegate,
                          HdRenderParam* renderParam,
                          HdDirtyBits* dirtyBits) {
-
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
-    auto rprApi = rprRenderParam->AcquireRprApiForEdit();
+    rprRenderParam->BeginSync();
 
     if (*dirtyBits & HdMaterial::DirtyResource) {
+        SdfPath materialPath;
+
         VtValue vtMat = sceneDelegate->GetMaterialResource(GetId());
         if (vtMat.IsHolding<HdMaterialNetworkMap>()) {
             auto& networkMap = vtMat.UncheckedGet<HdMaterialNetworkMap>();
+            materialPath = rprRenderParam->materialRegistry.Acquire(networkMap);
+            m_stName = GetStName(networkMap);
+        } else {
+            TF_CODING_WARNING("Material type not supported");
+        }
 
-            EMaterialType surfaceType = EMaterialType::NONE;
-            HdMaterialNetwork const* surface = nullptr;
-
-            EMaterialType displacementType = EMaterialType::NONE;
-            HdMaterialNetwork const* displacement = nullptr;
-
-            if (GetMaterialNetwork(HdMaterialTerminalTokens->surface, sceneDelegate, networkMap, *rprRenderParam, &surfaceType, &surface)) {
-                if (GetMaterialNetwork(HdMaterialTerminalTokens->displacement, sceneDelegate, networkMap, *rprRenderParam, &displacementType, &displacement)) {
-                    if (displacementType != surfaceType) {
-                        displacement = nullptr;
-                    }
-                }
+        // Release after acquire so that unchanged network does not recreate the material layer
+        rprRenderParam->materialRegistry.Release(m_materialPath);
 
-                MaterialAdapter matAdapter(surfaceType, *surface, displacement ? *displacement : HdMaterialNetwork{});
-                m_stName = matAdapter.GetStName();
-                m_rprMaterial = rprApi->CreateMaterial(matAdapter);
-            } else {
-                TF_CODING_WARNING("Material type not supported");
-            }
+        if (m_materialPath != materialPath) {
+            m_materialPath = materialPath;
+            rprRenderParam->MaterialDidChange(sceneDelegate, GetId());
         }
     }
 
@@ -122,14 +94,10 @@ void HdRprMaterial::Reload() {
 }
 
 void HdRprMaterial::Finalize(HdRenderParam* renderParam) {
-    static_cast<HdRprRenderParam*>(renderParam)->AcquireRprApiForEdit()->Release(m_rprMaterial);
-    m_rprMaterial = nullptr;
+    static_cast<HdRprRenderParam*>(renderParam)->materialRegistry.Release(m_materialPath);
+    m_materialPath = SdfPath();
 
     HdMaterial::Finalize(renderParam);
 }
 
-HdRprApiMaterial const* HdRprMaterial::GetRprMaterialObject() const {
-    return m_rprMaterial;
-}
-
 PXR_NAMESPACE_CLOSE_SCOPE
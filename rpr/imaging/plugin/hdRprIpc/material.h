@@ -18,8 +18,6 @@ limitations under the License.
 
 PXR_NAMESPACE_OPEN_SCOPE
 
-struct HdRprApiMaterial;
-
 class HdRprMaterial final : public HdMaterial {
 public:
     HdRprMaterial(SdfPath const& id);
@@ -35,14 +33,15 @@ public:
     void Reload() override;
     void Finalize(HdRenderParam* renderParam) override;
 
-    /// Get pointer to RPR material
-    /// In case material сreation failure return nullptr
-    HdRprApiMaterial const* GetRprMaterialObject() const;
+    /// Get path of the material sent to the viewer.
+    /// Materials with identical networks share the same path.
+    /// In case material сreation failure return empty path
+    SdfPath const& GetMaterialPath() const { return m_materialPath; }
 
     TfToken const& GetStName() const { return m_stName; }
 
 private:
-    HdRprApiMaterial* m_rprMaterial = nullptr;
+    SdfPath m_materialPath;
     TfToken m_stName;
 };
 
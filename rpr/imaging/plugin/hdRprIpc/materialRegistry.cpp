@@ -0,0 +1,348 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "materialRegistry.h"
+#include "layerUtils.h"
+
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/sdr/registry.h"
+#include "pxr/usd/sdr/shaderNode.h"
+#include "pxr/usd/sdr/shaderProperty.h"
+
+#include <algorithm>
+#include <limits>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    (Material)
+    (Shader)
+    (Scope)
+    ((infoId, "info:id"))
+    ((inputsPrefix, "inputs:"))
+    ((outputsPrefix, "outputs:"))
+);
+
+namespace {
+
+const SdfPath kMaterialsPath("/RprIpc/Materials");
+
+void HashCombine(size_t& hash, size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+std::map<SdfPath, size_t> GetNodeIndices(HdMaterialNetwork const& network) {
+    std::map<SdfPath, size_t> nodeIndices;
+    for (size_t i = 0; i < network.nodes.size(); ++i) {
+        nodeIndices.emplace(network.nodes[i].path, i);
+    }
+    return nodeIndices;
+}
+
+size_t GetNodeIndex(std::map<SdfPath, size_t> const& nodeIndices, SdfPath const& path) {
+    auto it = nodeIndices.find(path);
+    return it != nodeIndices.end() ? it->second : std::numeric_limits<size_t>::max();
+}
+
+size_t GetTerminalIndex(HdMaterialNetwork const& network, std::vector<SdfPath> const& terminals) {
+    for (size_t i = 0; i < network.nodes.size(); ++i) {
+        if (std::find(terminals.begin(), terminals.end(), network.nodes[i].path) != terminals.end()) {
+            return i;
+        }
+    }
+    // Hydra puts the terminal node last when terminals are not specified
+    return network.nodes.size() - 1;
+}
+
+/// Nodes are referenced by their index in the network so that the hash
+/// does not depend on where the material is located in the scene
+size_t HashNetworkMap(HdMaterialNetworkMap const& networkMap) {
+    size_t hash = 0;
+    for (auto& entry : networkMap.map) {
+        auto& network = entry.second;
+        if (network.nodes.empty()) {
+            continue;
+        }
+
+        HashCombine(hash, entry.first.Hash());
+        for (auto& node : network.nodes) {
+            HashCombine(hash, node.identifier.Hash());
+            for (auto& param : node.parameters) {
+                HashCombine(hash, param.first.Hash());
+                HashCombine(hash, param.second.GetHash());
+            }
+        }
+
+        auto nodeIndices = GetNodeIndices(network);
+        for (auto& relationship : network.relationships) {
+            HashCombine(hash, GetNodeIndex(nodeIndices, relationship.inputId));
+            HashCombine(hash, relationship.inputName.Hash());
+            HashCombine(hash, GetNodeIndex(nodeIndices, relationship.outputId));
+            HashCombine(hash, relationship.outputName.Hash());
+        }
+
+        HashCombine(hash, GetTerminalIndex(network, networkMap.terminals));
+    }
+    return hash;
+}
+
+/// Structural equality that matches HashNetworkMap: scene paths of the nodes are not compared
+bool IsEqualNetworkMap(HdMaterialNetworkMap const& lhs, HdMaterialNetworkMap const& rhs) {
+    // Empty networks do not contribute to the hash either
+    auto countNetworks = [](HdMaterialNetworkMap const& networkMap) {
+        return std::count_if(networkMap.map.begin(), networkMap.map.end(), [](std::pair<const TfToken, HdMaterialNetwork> const& entry) {
+            return !entry.second.nodes.empty();
+        });
+    };
+    if (countNetworks(lhs) != countNetworks(rhs)) {
+        return false;
+    }
+
+    for (auto& lhsEntry : lhs.map) {
+        auto& lhsNetwork = lhsEntry.second;
+        if (lhsNetwork.nodes.empty()) {
+            continue;
+        }
+
+        auto rhsIt = rhs.map.find(lhsEntry.first);
+        if (rhsIt == rhs.map.end()) {
+            return false;
+        }
+
+        auto& rhsNetwork = rhsIt->second;
+        if (lhsNetwork.nodes.size() != rhsNetwork.nodes.size() ||
+            lhsNetwork.relationships.size() != rhsNetwork.relationships.size()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < lhsNetwork.nodes.size(); ++i) {
+            if (lhsNetwork.nodes[i].identifier != rhsNetwork.nodes[i].identifier ||
+                lhsNetwork.nodes[i].parameters != rhsNetwork.nodes[i].parameters) {
+                return false;
+            }
+        }
+
+        auto lhsNodeIndices = GetNodeIndices(lhsNetwork);
+        auto rhsNodeIndices = GetNodeIndices(rhsNetwork);
+        for (size_t i = 0; i < lhsNetwork.relationships.size(); ++i) {
+            auto& lhsRelationship = lhsNetwork.relationships[i];
+            auto& rhsRelationship = rhsNetwork.relationships[i];
+            if (GetNodeIndex(lhsNodeIndices, lhsRelationship.inputId) != GetNodeIndex(rhsNodeIndices, rhsRelationship.inputId) ||
+                lhsRelationship.inputName != rhsRelationship.inputName ||
+                GetNodeIndex(lhsNodeIndices, lhsRelationship.outputId) != GetNodeIndex(rhsNodeIndices, rhsRelationship.outputId) ||
+                lhsRelationship.outputName != rhsRelationship.outputName) {
+                return false;
+            }
+        }
+
+        if (GetTerminalIndex(lhsNetwork, lhs.terminals) != GetTerminalIndex(rhsNetwork, rhs.terminals)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Returns type of \p name input or output of \p node as declared in the shader registry,
+/// falls back to the type of the authored parameter value
+SdfValueTypeName GetShaderPropertyType(HdMaterialNode const& node, TfToken const& name, bool isOutput) {
+    if (auto sdrNode = SdrRegistry::GetInstance().GetShaderNodeByIdentifier(node.identifier)) {
+        auto property = isOutput ? sdrNode->GetShaderOutput(name) : sdrNode->GetShaderInput(name);
+        if (property) {
+            auto typeName = property->GetTypeAsSdfType().first;
+            if (typeName) {
+                return typeName;
+            }
+        }
+    }
+
+    if (!isOutput) {
+        auto paramIt = node.parameters.find(name);
+        if (paramIt != node.parameters.end()) {
+            return SdfSchema::GetInstance().FindType(paramIt->second);
+        }
+    }
+    return SdfValueTypeName();
+}
+
+SdfAttributeSpecHandle CreateShaderAttribute(SdfPrimSpecHandle const& prim, TfToken const& prefix, TfToken const& name,
+                                             SdfValueTypeName const& typeName = SdfValueTypeNames->Token) {
+    return HdRprIpcCreateAttribute(prim, TfToken(prefix.GetString() + name.GetString()), typeName);
+}
+
+void Connect(SdfAttributeSpecHandle const& input, SdfAttributeSpecHandle const& output) {
+    input->GetConnectionPathList().GetExplicitItems() = SdfPathVector{output->GetPath()};
+}
+
+/// Authors \p networkMap as UsdShade material: each network of the map is placed into a scope
+/// named after its terminal, shaders are named after their index in the network
+void AuthorMaterial(SdfLayerHandle const& layer, SdfPath const& materialPath, HdMaterialNetworkMap const& networkMap) {
+    SdfChangeBlock changeBlock;
+
+    auto materialSpec = HdRprIpcDefinePrim(layer, materialPath, _tokens->Material);
+
+    for (auto& entry : networkMap.map) {
+        auto& terminalName = entry.first;
+        auto& network = entry.second;
+        if (network.nodes.empty()) {
+            continue;
+        }
+
+        auto networkPath = materialPath.AppendChild(terminalName);
+        HdRprIpcDefinePrim(layer, networkPath, _tokens->Scope);
+
+        std::map<SdfPath, std::pair<SdfPrimSpecHandle, HdMaterialNode const*>> shaders;
+        for (size_t i = 0; i < network.nodes.size(); ++i) {
+            auto& node = network.nodes[i];
+
+            auto shaderPath = networkPath.AppendChild(TfToken(TfStringPrintf("node%zu", i)));
+            auto shaderSpec = HdRprIpcDefinePrim(layer, shaderPath, _tokens->Shader);
+            shaders.emplace(node.path, std::make_pair(shaderSpec, &node));
+
+            auto idAttr = HdRprIpcCreateAttribute(shaderSpec, _tokens->infoId, SdfValueTypeNames->Token, SdfVariabilityUniform);
+            HdRprIpcSetAttributeValue(idAttr, node.identifier);
+
+            for (auto& param : node.parameters) {
+                auto typeName = SdfSchema::GetInstance().FindType(param.second);
+                if (!typeName) {
+                    TF_WARN("Unsupported type of %s parameter of %s node", param.first.GetText(), node.identifier.GetText());
+                    continue;
+                }
+
+                auto inputName = TfToken(_tokens->inputsPrefix.GetString() + param.first.GetString());
+                auto inputAttr = HdRprIpcCreateAttribute(shaderSpec, inputName, typeName);
+                inputAttr->SetDefaultValue(param.second);
+            }
+        }
+
+        for (auto& relationship : network.relationships) {
+            auto upstreamIt = shaders.find(relationship.inputId);
+            auto downstreamIt = shaders.find(relationship.outputId);
+            if (upstreamIt == shaders.end() || downstreamIt == shaders.end()) {
+                continue;
+            }
+
+            // Both ends of a connection share the type, whichever end the registry knows provides it
+            auto outputType = GetShaderPropertyType(*upstreamIt->second.second, relationship.inputName, true);
+            auto inputType = GetShaderPropertyType(*downstreamIt->second.second, relationship.outputName, false);
+            if (!outputType) {
+                outputType = inputType ? inputType : SdfValueTypeNames->Token;
+            }
+            if (!inputType) {
+                inputType = outputType;
+            }
+
+            auto output = CreateShaderAttribute(upstreamIt->second.first, _tokens->outputsPrefix, relationship.inputName, outputType);
+            auto input = CreateShaderAttribute(downstreamIt->second.first, _tokens->inputsPrefix, relationship.outputName, inputType);
+            Connect(input, output);
+        }
+
+        auto& terminalNode = network.nodes[GetTerminalIndex(network, networkMap.terminals)];
+        // Terminal outputs are tokens in UsdShade
+        auto terminalOutput = CreateShaderAttribute(shaders[terminalNode.path].first, _tokens->outputsPrefix, terminalName);
+        auto materialOutput = CreateShaderAttribute(materialSpec, _tokens->outputsPrefix, terminalName);
+        Connect(materialOutput, terminalOutput);
+    }
+}
+
+SdfPath GetMaterialPath(size_t hash, size_t collisionIndex) {
+    // Networks with colliding hashes get a collision index appended
+    auto name = collisionIndex ? TfStringPrintf("M%016zx_%zu", hash, collisionIndex) : TfStringPrintf("M%016zx", hash);
+    return kMaterialsPath.AppendChild(TfToken(name));
+}
+
+} // namespace anonymous
+
+HdRprIpcMaterialRegistry::HdRprIpcMaterialRegistry(HdRprIpcServer* ipcServer)
+    : m_ipcServer(ipcServer) {
+
+}
+
+SdfPath HdRprIpcMaterialRegistry::Acquire(HdMaterialNetworkMap const& networkMap) {
+    auto hash = HashNetworkMap(networkMap);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // An equal network might sit behind a released slot, so all slots are checked before a free one is reused
+    auto& numCollisionSlots = m_numCollisionSlots[hash];
+    SdfPath materialPath;
+    for (size_t collisionIndex = 0; collisionIndex < numCollisionSlots; ++collisionIndex) {
+        auto slotPath = GetMaterialPath(hash, collisionIndex);
+
+        auto it = m_materials.find(slotPath);
+        if (it == m_materials.end()) {
+            if (materialPath.IsEmpty()) {
+                materialPath = slotPath;
+            }
+        } else if (IsEqualNetworkMap(it->second.networkMap, networkMap)) {
+            it->second.refCount++;
+            return slotPath;
+        }
+    }
+    if (materialPath.IsEmpty()) {
+        materialPath = GetMaterialPath(hash, numCollisionSlots);
+    }
+
+    auto layer = m_ipcServer->AddLayer(materialPath);
+    if (!layer) {
+        if (numCollisionSlots == 0) {
+            m_numCollisionSlots.erase(hash);
+        }
+        return SdfPath();
+    }
+
+    AuthorMaterial(layer->GetStage()->GetRootLayer(), materialPath, networkMap);
+    m_ipcServer->OnLayerEdit(materialPath, layer);
+
+    m_materials.emplace(materialPath, Material{layer, 1, networkMap, hash});
+    if (materialPath == GetMaterialPath(hash, numCollisionSlots)) {
+        numCollisionSlots++;
+    }
+    return materialPath;
+}
+
+void HdRprIpcMaterialRegistry::Release(SdfPath const& materialPath) {
+    if (materialPath.IsEmpty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_materials.find(materialPath);
+    if (it == m_materials.end()) {
+        return;
+    }
+
+    if (--it->second.refCount == 0) {
+        auto hash = it->second.hash;
+        m_ipcServer->RemoveLayer(materialPath);
+        m_materials.erase(it);
+
+        // Trailing free slots need not be scanned
+        auto slotsIt = m_numCollisionSlots.find(hash);
+        if (slotsIt != m_numCollisionSlots.end()) {
+            auto& numCollisionSlots = slotsIt->second;
+            while (numCollisionSlots > 0 && !m_materials.count(GetMaterialPath(hash, numCollisionSlots - 1))) {
+                numCollisionSlots--;
+            }
+            if (numCollisionSlots == 0) {
+                m_numCollisionSlots.erase(slotsIt);
+            }
+        }
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
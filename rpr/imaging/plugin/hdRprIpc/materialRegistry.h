@@ -0,0 +1,66 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_MATERIAL_REGISTRY_H
+#define HDRPR_MATERIAL_REGISTRY_H
+
+#include "ipcServer.h"
+
+#include "pxr/imaging/hd/material.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <mutex>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Owns material layers that are sent to the viewer.
+/// Material networks are hashed structurally (scene paths of the nodes do not
+/// contribute to the hash), so identical networks, e.g. duplicates of the same
+/// library material, are sent and compiled by the viewer only once.
+class HdRprIpcMaterialRegistry {
+public:
+    HdRprIpcMaterialRegistry(HdRprIpcServer* ipcServer);
+    ~HdRprIpcMaterialRegistry() = default;
+
+    HdRprIpcMaterialRegistry(const HdRprIpcMaterialRegistry&) = delete;
+    HdRprIpcMaterialRegistry& operator =(const HdRprIpcMaterialRegistry&) = delete;
+
+    /// Returns path of the material that represents \p networkMap.
+    /// The material layer is sent only when no other material with the same network exists.
+    /// Returns an empty path on failure
+    SdfPath Acquire(HdMaterialNetworkMap const& networkMap);
+
+    /// Releases material acquired with Acquire, the material layer is removed with the last reference
+    void Release(SdfPath const& materialPath);
+
+private:
+    struct Material {
+        RprIpcServer::Layer* layer;
+        size_t refCount;
+        // Kept to tell apart networks with colliding hashes
+        HdMaterialNetworkMap networkMap;
+        size_t hash;
+    };
+
+    HdRprIpcServer* m_ipcServer;
+
+    std::mutex m_mutex;
+    std::map<SdfPath, Material> m_materials;
+    // Number of collision slots of a hash that might be occupied, released slots leave gaps
+    std::map<size_t, size_t> m_numCollisionSlots;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_MATERIAL_REGISTRY_H
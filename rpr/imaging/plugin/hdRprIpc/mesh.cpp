@@ -12,10 +12,122 @@ limitations under the License.
 ************************************************************************/
 
 #include "mesh.h"
+#include "material.h"
 #include "renderParam.h"
+#include "renderDelegate.h"
+#include "layerUtils.h"
+
+#include "pxr/base/gf/bbox3d.h"
+#include "pxr/imaging/hd/renderIndex.h"
+#include "pxr/imaging/hd/timeSampleArray.h"
+#include "pxr/imaging/pxOsd/tokens.h"
+#include "pxr/usd/usdGeom/tokens.h"
+#include "pxr/base/work/loops.h"
+
+#include <algorithm>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    (usdc)
+    (Mesh)
+    (Xform)
+    (client)
+    ((materialBinding, "material:binding"))
+    ((primvarsPrefix, "primvars:"))
+);
+
+namespace {
+
+constexpr unsigned int kMaxTimeSamples = 16;
+
+/// Checks whether a mesh of \p topology is uploaded as parts of at most \p maxPartFaces faces.
+/// Every part of a subdivision surface would be refined on its own and crack along the cuts, so they are not split
+bool IsSplit(HdMeshTopology const& topology, int maxPartFaces) {
+    return topology.GetNumFaces() > maxPartFaces && topology.GetScheme() == PxOsdOpenSubdivTokens->none;
+}
+
+/// Resamples \p samples to \p numSamples samples uniformly distributed over the shutter interval.
+/// Returns empty map if there is no motion
+template <typename T, unsigned int CAPACITY>
+SdfTimeSampleMap GetMotionSamples(HdTimeSampleArray<T, CAPACITY> const& samples, float frame, int numSamples) {
+    SdfTimeSampleMap timeSamples;
+    if (samples.count < 2) {
+        return timeSamples;
+    }
+
+    float shutterOpen = samples.times[0];
+    float shutterClose = samples.times[samples.count - 1];
+    for (int i = 0; i < numSamples; ++i) {
+        float time = shutterOpen + (shutterClose - shutterOpen) * i / (numSamples - 1);
+        timeSamples.emplace(frame + time, VtValue(samples.Resample(time)));
+    }
+    return timeSamples;
+}
+
+/// Moves arrays held by the default value and time samples of \p attr out of the layer and clears them.
+/// Storage of an array that nothing else shares is then reused when it is written to
+std::vector<VtVec3fArray> TakeArrays(SdfAttributeSpecHandle const& attr) {
+    std::vector<VtVec3fArray> arrays;
+    auto takeArray = [&arrays](VtValue* value) {
+        if (value->IsHolding<VtVec3fArray>()) {
+            arrays.emplace_back();
+            value->UncheckedSwap(arrays.back());
+        }
+    };
+
+    VtValue defaultValue;
+    if (attr->HasDefaultValue()) {
+        defaultValue = attr->GetDefaultValue();
+        attr->ClearDefaultValue();
+    }
+    VtValue timeSamples;
+    if (attr->HasInfo(SdfFieldKeys->TimeSamples)) {
+        timeSamples = attr->GetInfo(SdfFieldKeys->TimeSamples);
+        attr->ClearInfo(SdfFieldKeys->TimeSamples);
+    }
+
+    // The layer no longer references the values, so the swaps below do not copy them
+    takeArray(&defaultValue);
+    if (timeSamples.IsHolding<SdfTimeSampleMap>()) {
+        SdfTimeSampleMap samples;
+        timeSamples.UncheckedSwap(samples);
+        for (auto& sample : samples) {
+            takeArray(&sample.second);
+        }
+    }
+    return arrays;
+}
+
+/// Equivalent of Hd_SmoothNormals::ComputeSmoothNormals that writes into \p normals instead of a new array
+void ComputeSmoothNormals(Hd_VertexAdjacency const& adjacency, VtVec3fArray const& points, VtVec3fArray* normals) {
+    size_t numPoints = std::min(points.size(), size_t(std::max(adjacency.GetNumPoints(), 0)));
+    normals->resize(numPoints);
+
+    auto& adjacencyTable = adjacency.GetAdjacencyTable();
+    auto pointsData = points.cdata();
+    auto normalsData = normals->data();
+    WorkParallelForN(numPoints, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            // Every point has its offset and valence followed by valence pairs of previous and next points
+            int offset = adjacencyTable[i * 2];
+            int valence = adjacencyTable[i * 2 + 1];
+
+            auto& point = pointsData[i];
+            GfVec3f normal(0.0f);
+            for (int j = 0; j < valence; ++j) {
+                auto& prev = pointsData[adjacencyTable[offset + j * 2]];
+                auto& next = pointsData[adjacencyTable[offset + j * 2 + 1]];
+                normal += GfCross(next - point, prev - point);
+            }
+            normal.Normalize();
+            normalsData[i] = normal;
+        }
+    });
+}
+
+} // namespace anonymous
+
 HdRprMesh::HdRprMesh(SdfPath const& id, SdfPath const& instancerId)
     : HdMesh(id, instancerId) {
 
@@ -42,6 +154,7 @@ HdDirtyBits HdRprMesh::GetInitialDirtyBitsMask() const {
         | HdChangeTracker::DirtyInstancer
         | HdChangeTracker::DirtyInstanceIndex
         | HdChangeTracker::DirtyDoubleSided
+        | HdChangeTracker::DirtyRenderTag
         ;
 
     return (HdDirtyBits)mask;
@@ -63,6 +176,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
     HF_MALLOC_TAG_FUNCTION();
 
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
+    rprRenderParam->BeginSync();
 
     SdfPath const& id = GetId();
 
@@ -71,37 +185,145 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
 
     bool updateLayer = false;
 
-    if (!m_layer) {
-        m_layer = rprRenderParam->ipcServer->AddLayer(id);
-        if (!m_layer) {
-            *dirtyBits = HdChangeTracker::Clean;
-            return;
+    auto renderDelegate = rprRenderParam->renderDelegate;
+
+    if (*dirtyBits & HdChangeTracker::DirtyRenderTag) {
+        m_renderTag = sceneDelegate->GetRenderTag(id);
+    }
+
+    auto renderTagFilter = &rprRenderParam->renderTagFilter;
+    if (!renderTagFilter->IsActive(m_renderTag)) {
+        // Prims that are not drawn by the current render pass are not sent,
+        // dirty bits are kept so that the prim is populated once its tag is activated
+        if (m_primSpec) {
+            // The prim's own tag has been switched to an inactive one
+            renderTagFilter->RemovePrim(id);
+            Unpublish();
+            *dirtyBits |= HdChangeTracker::AllDirty;
+        }
+        *dirtyBits &= ~HdChangeTracker::DirtyRenderTag;
+        return;
+    }
+
+    if (*dirtyBits & HdChangeTracker::DirtyRenderTag || !m_primSpec) {
+        renderTagFilter->SetPublished(id, m_renderTag, this);
+    }
+
+    // Held for the whole sync when the prim is authored into a shared chunk layer
+    std::unique_lock<std::mutex> chunkLock;
+
+    ScenePoints scenePoints(sceneDelegate, id);
+
+    if (!m_primSpec) {
+        auto numPoints = scenePoints.GetSize();
+
+        // A prim that another render delegate of the session has already published
+        // is authored into the same layer the way that delegate has chosen
+        auto& chunkAggregator = rprRenderParam->chunkAggregator;
+        bool isAggregated = chunkAggregator.HasPrim(id);
+        bool isShared = isAggregated || rprRenderParam->ipcServer->HasLayer(id);
+
+        int aggregationMaxPoints = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->aggregationMaxPoints, 0);
+        if (isAggregated || (!isShared && aggregationMaxPoints > 0 && numPoints <= size_t(aggregationMaxPoints))) {
+            int aggregationChunkSize = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->aggregationChunkSize, 1024);
+            m_chunk = chunkAggregator.AddPrim(id, std::max(aggregationChunkSize, 1));
         }
 
-        auto stage = m_layer->GetStage();
-        m_mesh = UsdGeomMesh::Define(stage, id);
-        stage->SetDefaultPrim(m_mesh.GetPrim());
+        SdfLayerHandle layer;
+        if (m_chunk) {
+            chunkLock = std::unique_lock<std::mutex>(m_chunk->GetMutex());
+            layer = m_chunk->GetLayer();
+        } else {
+            m_layer = rprRenderParam->ipcServer->AddLayer(id);
+            if (!m_layer) {
+                *dirtyBits = HdChangeTracker::Clean;
+                return;
+            }
+
+            layer = m_layer->GetStage()->GetRootLayer();
+            layer->SetDefaultPrim(id.GetNameToken());
+        }
+        m_primSpec = HdRprIpcDefinePrim(layer, id, _tokens->Mesh);
+        m_renderParam = rprRenderParam;
+
+        // Siblings are grouped under their parent so that moving the parent is sent as a single transform
+        auto parentPath = id.GetParentPath();
+        m_inTransformHierarchy = rprRenderParam->transformHierarchy.HasChild(id) ||
+            (!isShared && renderDelegate->GetRenderSetting(HdRprIpcRenderSettingsTokens->transformHierarchy, false) &&
+             parentPath != SdfPath::AbsoluteRootPath() && !sceneDelegate->GetRenderIndex().HasRprim(parentPath));
+
+        // Heavy meshes are shown as a proxy box until their payload is written in background
+        int proxyMinPoints = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->proxyMinPoints, 0);
+        m_useProxy = !m_chunk && proxyMinPoints > 0 && numPoints >= size_t(proxyMinPoints);
+
+        // Meshes that are uploaded in parts are always sent as binary payloads
+        int uploadPartFaces = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->uploadPartFaces, 0);
+        bool useUploadParts = uploadPartFaces > 0 && IsSplit(GetMeshTopology(sceneDelegate), uploadPartFaces);
+
+        // Aggregated prims are small by definition, there is no benefit in a separate payload for them
+        auto geometryFormat = renderDelegate->GetRenderSetting(HdRprIpcRenderSettingsTokens->geometryFormat, TfToken());
+        m_useBinaryPayload = !m_chunk && (geometryFormat == _tokens->usdc || m_useProxy || useUploadParts);
+        if (!m_useBinaryPayload) {
+            m_geometrySpec = m_primSpec;
+        }
 
         updateLayer = true;
+    } else if (m_chunk) {
+        chunkLock = std::unique_lock<std::mutex>(m_chunk->GetMutex());
     }
 
-    // auto meshPrim = m_mesh.GetPrim();
-    // auto materialRel = meshPrim.CreateRelationship(UsdShadeTokens->materialBinding, false);
-    // materialRel.SetTargets({m_scopes[kMaterialScope].GetLayerPath(meshData.materialId)});
+    bool updateGeometry = false;
 
-    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->points)) {
-        m_mesh.CreatePointsAttr(sceneDelegate->Get(id, HdTokens->points));
+    if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
+        auto materialId = sceneDelegate->GetMaterialId(id);
+        if (m_materialId != materialId) {
+            rprRenderParam->UnsubscribeFromMaterialUpdates(m_materialId, id);
+            m_materialId = materialId;
+            if (!m_materialId.IsEmpty()) {
+                rprRenderParam->SubscribeForMaterialUpdates(m_materialId, id);
+            }
+        }
 
-        updateLayer = true;
+        // Identical materials are deduplicated, bind the shared one
+        SdfPath materialPath;
+        auto material = static_cast<const HdRprMaterial*>(sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, m_materialId));
+        if (material) {
+            materialPath = material->GetMaterialPath();
+        }
+        updateLayer |= HdRprIpcSetRelationshipTarget(m_primSpec, _tokens->materialBinding, materialPath);
+
+        // The new material may read texture coordinates from another primvar
+        auto stName = material ? material->GetStName() : TfToken();
+        if (m_stName != stName) {
+            m_stName = stName;
+            *dirtyBits |= HdChangeTracker::DirtyPrimvar;
+        }
     }
 
-    if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
-        auto topology = GetMeshTopology(sceneDelegate);
-        m_mesh.CreateFaceVertexCountsAttr(VtValue(topology.GetFaceVertexCounts()));
-        m_mesh.CreateFaceVertexIndicesAttr(VtValue(topology.GetFaceVertexIndices()));
-        m_mesh.CreateSubdivisionSchemeAttr(VtValue(topology.GetScheme()));
+    bool isStDirty = !m_stName.IsEmpty() && HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, m_stName);
+
+    if (!m_geometrySpec &&
+        (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->points) ||
+         HdChangeTracker::IsTopologyDirty(*dirtyBits, id) || isStDirty)) {
+        // Geometry is either new or was released after it has been sent.
+        // The payload is always written as a whole so author it from scratch
+        m_geometryLayer = SdfLayer::CreateAnonymous(".usdc");
+        m_geometrySpec = HdRprIpcDefinePrim(m_geometryLayer, id, _tokens->Mesh);
+        *dirtyBits |= HdChangeTracker::DirtyPoints | HdChangeTracker::DirtyTopology;
+        isStDirty = !m_stName.IsEmpty();
+    }
 
-        updateLayer = true;
+    TimeSampling timeSampling;
+    timeSampling.frame = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->frame, 0.0f);
+    timeSampling.motionBlurSamples = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->motionBlurSamples, 1);
+
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->points)) {
+        updateGeometry |= SyncPoints(sceneDelegate, timeSampling, &scenePoints);
+    }
+
+    if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
+        SyncTopology(sceneDelegate);
+        updateGeometry = true;
     }
 
     // std::map<HdInterpolation, HdPrimvarDescriptorVector> primvarDescsPerInterpolation = {
@@ -110,30 +332,30 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
     //     {HdInterpolationConstant, sceneDelegate->GetPrimvarDescriptors(id, HdInterpolationConstant)},
     // };
 
-    // if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->normals)) {
-    //     m_authoredNormals = GetPrimvarData(HdTokens->normals, sceneDelegate, primvarDescsPerInterpolation, m_normals, m_normalIndices);
-
-    //     updateLayer = true;
-    // }
-
-    // if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
-    //     m_cachedMaterialId = sceneDelegate->GetMaterialId(id);
-    // }
+    // Huge meshes are written in background as separate parts
+    size_t maxPartFaces = 0;
+    if (m_useBinaryPayload) {
+        int uploadPartFaces = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->uploadPartFaces, 0);
+        if (uploadPartFaces > 0 && IsSplit(m_topology, uploadPartFaces)) {
+            maxPartFaces = size_t(uploadPartFaces);
+        }
+    }
 
-    // auto material = static_cast<const HdRprMaterial*>(sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, m_cachedMaterialId));
-    // if (material) {
-    //     if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, material->GetStName())) {
-    //         GetPrimvarData(material->GetStName(), sceneDelegate, primvarDescsPerInterpolation, m_uvs, m_uvIndices);
+    if (updateGeometry || HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->normals)) {
+        // Normals generated by the viewer for every part on its own would have seams along the cuts,
+        // normals of the whole mesh are split along with the points instead
+        auto normalsSource = renderDelegate->GetRenderSetting(HdRprIpcRenderSettingsTokens->normalsSource, TfToken());
+        updateGeometry |= SyncNormals(sceneDelegate, normalsSource == _tokens->client || maxPartFaces);
+    }
 
-    //         updateLayer = true;
-    //     }
-    // }
+    if (isStDirty) {
+        updateGeometry |= SyncUvs(sceneDelegate);
+    }
 
     if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
-        m_mesh.CreateVisibilityAttr(VtValue(sceneDelegate->GetVisible(id)));
-
+        auto visibilityAttr = HdRprIpcCreateAttribute(m_primSpec, UsdGeomTokens->visibility, SdfValueTypeNames->Token);
         // TODO: consider some sort of optimization for this (maybe wrap this layer into another layer with wrapping Xform)
-        updateLayer = true;
+        updateLayer |= HdRprIpcSetAttributeValue(visibilityAttr, sceneDelegate->GetVisible(id) ? UsdGeomTokens->inherited : UsdGeomTokens->invisible);
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -165,48 +387,391 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
     //     }
     // }
 
-    // m_smoothNormals = m_displayStyle.flatShadingEnabled;
-    // // Don't compute smooth normals on a refined m_mesh. They are implicitly smooth.
-    // m_smoothNormals = m_smoothNormals && !(m_enableSubdiv && m_refineLevel > 0);
-
-    // if (!m_authoredNormals && m_smoothNormals) {
-    //     if (!m_adjacencyValid) {
-    //         m_adjacency.BuildAdjacencyTable(&m_topology);
-    //         m_adjacencyValid = true;
-    //         m_normalsValid = false;
-    //     }
+    if (*dirtyBits & HdChangeTracker::DirtyTransform) {
+        if (m_inTransformHierarchy && timeSampling.motionBlurSamples > 1) {
+            // Time sampled transforms are sent in world space
+            rprRenderParam->transformHierarchy.RemoveChild(id, this);
+            m_inTransformHierarchy = false;
+        }
 
-    //     if (!m_normalsValid) {
-    //         m_normals = Hd_SmoothNormals::ComputeSmoothNormals(&m_adjacency, m_points.size(), m_points.cdata());
-    //         m_normalsValid = true;
+        if (m_inTransformHierarchy) {
+            // Local transform is authored by the hierarchy once all prims are synced
+            rprRenderParam->transformHierarchy.SetWorldTransform(id, sceneDelegate->GetTransform(id), this);
+        } else {
+            updateLayer |= SyncTransform(sceneDelegate, timeSampling);
+        }
+    }
 
-    //         updateLayer = true;
-    //     }
-    // }
+    if (updateGeometry) {
+        if (m_useBinaryPayload) {
+            HDRPRIPC_MALLOC_TAG("Payload");
+
+            if (m_useProxy || maxPartFaces) {
+                // The background writer gets its own copy so that later edits do not race with it.
+                // Arrays are shared between the copies, only specs are duplicated
+                auto geometryLayer = SdfLayer::CreateAnonymous(".usdc");
+                geometryLayer->TransferContent(m_geometryLayer);
+                rprRenderParam->backgroundUploads.Push(id, geometryLayer, maxPartFaces, this);
+
+                if (m_useProxy && !m_hasPayload) {
+                    SetProxyGeometry(sceneDelegate, &scenePoints);
+                }
+            } else {
+                SetPayload({rprRenderParam->payloadStore.WriteLayerPayload(id, m_geometryLayer)});
+            }
+
+            if (renderDelegate->GetRenderSetting(HdRprIpcRenderSettingsTokens->dropSentGeometry, false)) {
+                // The viewer reads geometry from the payload, there is no need to keep a copy here
+                m_geometrySpec = SdfPrimSpecHandle();
+                m_geometryLayer = SdfLayerRefPtr();
+                m_topology = HdMeshTopology();
+                m_adjacency = Hd_VertexAdjacency();
+                m_adjacencyValid = false;
+            }
+        }
 
-    if (*dirtyBits & HdChangeTracker::DirtyTransform) {
-        m_mesh.MakeMatrixXform().Set(sceneDelegate->GetTransform(id));
+        rprRenderParam->SetPrimMemoryUsage(id, m_geometrySpec ? HdRprIpcGetArraysMemory(m_geometrySpec) : 0);
 
-        // TODO: consider some sort of optimization for this (maybe wrap this layer into another layer with wrapping Xform)
         updateLayer = true;
     }
 
     if (updateLayer) {
-        rprRenderParam->ipcServer->OnLayerEdit(id, m_layer);
+        int streamingPointsBudget = HdRprIpcGetNumericRenderSetting(renderDelegate, HdRprIpcRenderSettingsTokens->streamingPointsBudget, 0);
+
+        if (m_chunk) {
+            // Dirty chunks are published once all prims are synced
+            m_chunk->MarkDirty();
+        } else if (!m_isPublished && streamingPointsBudget > 0) {
+            // Initial layer is streamed by the render pass in order of screen-space priority
+            auto worldExtent = GfBBox3d(sceneDelegate->GetExtent(id), sceneDelegate->GetTransform(id)).ComputeAlignedRange();
+            rprRenderParam->publishQueue.Push(id, worldExtent, scenePoints.GetSize(), this);
+        } else {
+            Publish();
+        }
     }
 
     *dirtyBits = HdChangeTracker::Clean;
 }
 
+VtValue const& HdRprMesh::ScenePoints::Get() {
+    if (!m_isFetched) {
+        m_points = m_sceneDelegate->Get(m_id, HdTokens->points);
+        m_isFetched = true;
+    }
+    return m_points;
+}
+
+bool HdRprMesh::SyncPoints(HdSceneDelegate* sceneDelegate, TimeSampling const& timeSampling, ScenePoints* scenePoints) {
+    HDRPRIPC_MALLOC_TAG("Points");
+
+    auto pointsAttr = HdRprIpcCreateAttribute(m_geometrySpec, UsdGeomTokens->points, SdfValueTypeNames->Point3fArray);
+
+    if (timeSampling.motionBlurSamples > 1) {
+        // All shutter samples share the topology and go to the viewer within the same layer edit
+        HdTimeSampleArray<VtValue, kMaxTimeSamples> samples;
+        sceneDelegate->SamplePrimvar(GetId(), HdTokens->points, &samples);
+
+        auto timeSamples = GetMotionSamples(samples, timeSampling.frame, timeSampling.motionBlurSamples);
+        if (!timeSamples.empty()) {
+            HdRprIpcSetAttributeTimeSamples(pointsAttr, std::move(timeSamples));
+            return true;
+        }
+    }
+
+    HdRprIpcSetAttributeValue(pointsAttr, scenePoints->Get());
+    return true;
+}
+
+void HdRprMesh::SyncTopology(HdSceneDelegate* sceneDelegate) {
+    HDRPRIPC_MALLOC_TAG("Topology");
+
+    m_topology = GetMeshTopology(sceneDelegate);
+    m_adjacencyValid = false;
+
+    auto& topology = m_topology;
+
+    auto faceVertexCountsAttr = HdRprIpcCreateAttribute(m_geometrySpec, UsdGeomTokens->faceVertexCounts, SdfValueTypeNames->IntArray);
+    HdRprIpcSetAttributeValue(faceVertexCountsAttr, topology.GetFaceVertexCounts());
+
+    auto faceVertexIndicesAttr = HdRprIpcCreateAttribute(m_geometrySpec, UsdGeomTokens->faceVertexIndices, SdfValueTypeNames->IntArray);
+    HdRprIpcSetAttributeValue(faceVertexIndicesAttr, topology.GetFaceVertexIndices());
+
+    auto subdivisionSchemeAttr = HdRprIpcCreateAttribute(m_geometrySpec, UsdGeomTokens->subdivisionScheme, SdfValueTypeNames->Token, SdfVariabilityUniform);
+    HdRprIpcSetAttributeValue(subdivisionSchemeAttr, topology.GetScheme());
+}
+
+bool HdRprMesh::SyncUvs(HdSceneDelegate* sceneDelegate) {
+    HDRPRIPC_MALLOC_TAG("Uvs");
+
+    auto uvsName = TfToken(_tokens->primvarsPrefix.GetString() + m_stName.GetString());
+
+    for (auto interpolation : {HdInterpolationVertex, HdInterpolationVarying, HdInterpolationFaceVarying}) {
+        for (auto& primvar : sceneDelegate->GetPrimvarDescriptors(GetId(), interpolation)) {
+            if (primvar.name != m_stName) {
+                continue;
+            }
+
+            auto uvs = sceneDelegate->Get(GetId(), m_stName);
+            if (!uvs.IsHolding<VtVec2fArray>()) {
+                return false;
+            }
+
+            auto uvsAttr = HdRprIpcCreateAttribute(m_geometrySpec, uvsName, SdfValueTypeNames->TexCoord2fArray);
+            uvsAttr->SetInfo(UsdGeomTokens->interpolation, VtValue(interpolation == HdInterpolationFaceVarying ? UsdGeomTokens->faceVarying : UsdGeomTokens->vertex));
+            HdRprIpcSetAttributeValue(uvsAttr, uvs);
+            return true;
+        }
+    }
+
+    if (auto uvsAttr = m_geometrySpec->GetLayer()->GetAttributeAtPath(m_geometrySpec->GetPath().AppendProperty(uvsName))) {
+        m_geometrySpec->RemoveProperty(uvsAttr);
+        return true;
+    }
+    return false;
+}
+
+bool HdRprMesh::SyncNormals(HdSceneDelegate* sceneDelegate, bool computeSmoothNormals) {
+    HDRPRIPC_MALLOC_TAG("Normals");
+
+    auto layer = m_geometrySpec->GetLayer();
+    auto normalsPath = m_geometrySpec->GetPath().AppendProperty(UsdGeomTokens->normals);
+
+    // Authored normals take precedence over generated ones
+    for (auto interpolation : {HdInterpolationVertex, HdInterpolationVarying, HdInterpolationFaceVarying}) {
+        for (auto& primvar : sceneDelegate->GetPrimvarDescriptors(GetId(), interpolation)) {
+            if (primvar.name == HdTokens->normals) {
+                auto normalsAttr = HdRprIpcCreateAttribute(m_geometrySpec, UsdGeomTokens->normals, SdfValueTypeNames->Normal3fArray);
+                normalsAttr->SetInfo(UsdGeomTokens->interpolation, VtValue(interpolation == HdInterpolationFaceVarying ? UsdGeomTokens->faceVarying : UsdGeomTokens->vertex));
+                HdRprIpcSetAttributeValue(normalsAttr, sceneDelegate->Get(GetId(), HdTokens->normals));
+                return true;
+            }
+        }
+    }
+
+    if (!computeSmoothNormals) {
+        // The viewer generates normals itself when none are authored
+        if (auto normalsAttr = layer->GetAttributeAtPath(normalsPath)) {
+            m_geometrySpec->RemoveProperty(normalsAttr);
+            return true;
+        }
+        return false;
+    }
+
+    auto pointsAttr = layer->GetAttributeAtPath(m_geometrySpec->GetPath().AppendProperty(UsdGeomTokens->points));
+    if (!pointsAttr) {
+        return false;
+    }
+
+    // Adjacency depends on topology only, deforming meshes reuse it for every points update
+    if (!m_adjacencyValid) {
+        m_adjacency.BuildAdjacencyTable(&m_topology);
+        m_adjacencyValid = true;
+    }
+
+    auto normalsAttr = HdRprIpcCreateAttribute(m_geometrySpec, UsdGeomTokens->normals, SdfValueTypeNames->Normal3fArray);
+    normalsAttr->SetInfo(UsdGeomTokens->interpolation, VtValue(UsdGeomTokens->vertex));
+
+    // Deforming meshes recompute normals on every points edit. Arrays of the previous edit are
+    // recycled, unless a payload upload still shares them they keep their storage
+    auto prevNormals = TakeArrays(normalsAttr);
+
+    auto smoothNormals = [this, &prevNormals](VtValue const& points) {
+        if (!points.IsHolding<VtVec3fArray>()) {
+            return VtValue();
+        }
+
+        VtVec3fArray normals;
+        if (!prevNormals.empty()) {
+            normals.swap(prevNormals.back());
+            prevNormals.pop_back();
+        }
+
+        // Runs in parallel over points
+        ComputeSmoothNormals(m_adjacency, points.UncheckedGet<VtVec3fArray>(), &normals);
+        return VtValue::Take(normals);
+    };
+
+    // Every points sample gets its own normals sample
+    auto times = layer->ListTimeSamplesForPath(pointsAttr->GetPath());
+    if (times.empty()) {
+        HdRprIpcSetAttributeValue(normalsAttr, smoothNormals(pointsAttr->GetDefaultValue()));
+    } else {
+        SdfTimeSampleMap timeSamples;
+        for (double time : times) {
+            VtValue points;
+            layer->QueryTimeSample(pointsAttr->GetPath(), time, &points);
+            timeSamples[time] = smoothNormals(points);
+        }
+        HdRprIpcSetAttributeTimeSamples(normalsAttr, std::move(timeSamples));
+    }
+
+    return true;
+}
+
+void HdRprMesh::SetLocalTransform(GfMatrix4d const& transform, bool isWorldSpace) {
+    std::unique_lock<std::mutex> chunkLock;
+    if (m_chunk) {
+        chunkLock = std::unique_lock<std::mutex>(m_chunk->GetMutex());
+    }
+
+    auto transformAttr = HdRprIpcCreateTransformAttribute(m_primSpec, isWorldSpace);
+    HdRprIpcSetAttributeValue(transformAttr, transform);
+
+    if (m_chunk) {
+        m_chunk->MarkDirty();
+    } else if (m_isPublished) {
+        m_renderParam->ipcServer->OnLayerEdit(GetId(), m_layer);
+    }
+}
+
+void HdRprMesh::SetPayload(std::vector<std::string> payloadPaths, bool isSplit) {
+    if (payloadPaths.empty() || std::any_of(payloadPaths.begin(), payloadPaths.end(), [](std::string const& path) { return path.empty(); })) {
+        for (auto& payloadPath : payloadPaths) {
+            m_renderParam->payloadStore.Remove(payloadPath);
+        }
+        return;
+    }
+
+    // Parts of a split mesh are composed from all payloads
+    SdfReferenceVector references;
+    for (auto& payloadPath : payloadPaths) {
+        references.emplace_back(payloadPath, GetId());
+    }
+    m_primSpec->GetReferenceList().GetExplicitItems() = references;
+
+    // Parts are child meshes and gprims can not be nested, so a split mesh becomes a group of its parts
+    auto& typeName = isSplit ? _tokens->Xform : _tokens->Mesh;
+    if (m_primSpec->GetTypeName() != typeName) {
+        m_primSpec->SetTypeName(typeName);
+    }
+
+    m_renderParam->payloadStore.SetLayerPayloads(GetId(), std::move(payloadPaths));
+    m_hasPayload = true;
+}
+
+void HdRprMesh::SetProxyGeometry(HdSceneDelegate* sceneDelegate, ScenePoints* scenePoints) {
+    auto extent = sceneDelegate->GetExtent(GetId());
+    if (extent.IsEmpty()) {
+        auto& points = scenePoints->Get();
+        if (points.IsHolding<VtVec3fArray>()) {
+            for (auto& point : points.UncheckedGet<VtVec3fArray>()) {
+                extent.UnionWith(GfVec3d(point));
+            }
+        }
+        if (extent.IsEmpty()) {
+            return;
+        }
+    }
+
+    // Authored on the mesh prim itself, these opinions are stronger than the payload reference
+    VtVec3fArray points(8);
+    for (int i = 0; i < 8; ++i) {
+        points[i] = GfVec3f(extent.GetCorner(i));
+    }
+    // GfRange3d corners are ordered LDB, RDB, LUB, RUB, LDF, RDF, LUF, RUF
+    VtIntArray faceVertexIndices = {
+        0, 2, 3, 1,
+        4, 5, 7, 6,
+        0, 1, 5, 4,
+        2, 6, 7, 3,
+        0, 4, 6, 2,
+        1, 3, 7, 5,
+    };
+
+    auto pointsAttr = HdRprIpcCreateAttribute(m_primSpec, UsdGeomTokens->points, SdfValueTypeNames->Point3fArray);
+    HdRprIpcSetAttributeValue(pointsAttr, points);
+
+    auto faceVertexCountsAttr = HdRprIpcCreateAttribute(m_primSpec, UsdGeomTokens->faceVertexCounts, SdfValueTypeNames->IntArray);
+    HdRprIpcSetAttributeValue(faceVertexCountsAttr, VtIntArray(6, 4));
+
+    auto faceVertexIndicesAttr = HdRprIpcCreateAttribute(m_primSpec, UsdGeomTokens->faceVertexIndices, SdfValueTypeNames->IntArray);
+    HdRprIpcSetAttributeValue(faceVertexIndicesAttr, faceVertexIndices);
+}
+
+void HdRprMesh::OnPayloadsWritten(std::vector<std::string> const& payloadPaths, bool isSplit) {
+    for (auto& name : {UsdGeomTokens->points, UsdGeomTokens->faceVertexCounts, UsdGeomTokens->faceVertexIndices}) {
+        if (auto proxyAttr = m_primSpec->GetLayer()->GetAttributeAtPath(m_primSpec->GetPath().AppendProperty(name))) {
+            m_primSpec->RemoveProperty(proxyAttr);
+        }
+    }
+    SetPayload(payloadPaths, isSplit);
+
+    if (m_isPublished) {
+        m_renderParam->ipcServer->OnLayerEdit(GetId(), m_layer);
+    }
+}
+
+void HdRprMesh::Publish() {
+    m_renderParam->ipcServer->OnLayerEdit(GetId(), m_layer);
+    m_isPublished = true;
+}
+
+bool HdRprMesh::SyncTransform(HdSceneDelegate* sceneDelegate, TimeSampling const& timeSampling) {
+    HDRPRIPC_MALLOC_TAG("Transform");
+
+    auto transformAttr = HdRprIpcCreateTransformAttribute(m_primSpec);
+
+    if (timeSampling.motionBlurSamples > 1) {
+        HdTimeSampleArray<GfMatrix4d, kMaxTimeSamples> samples;
+        sceneDelegate->SampleTransform(GetId(), &samples);
+
+        auto timeSamples = GetMotionSamples(samples, timeSampling.frame, timeSampling.motionBlurSamples);
+        if (!timeSamples.empty()) {
+            HdRprIpcSetAttributeTimeSamples(transformAttr, std::move(timeSamples));
+            return true;
+        }
+    }
+
+    return HdRprIpcSetAttributeValue(transformAttr, sceneDelegate->GetTransform(GetId()));
+}
+
 void HdRprMesh::Finalize(HdRenderParam* renderParam) {
-    if (m_layer) {
-        auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
+    auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
+
+    rprRenderParam->UnsubscribeFromMaterialUpdates(m_materialId, GetId());
+    m_materialId = SdfPath();
 
-        rprRenderParam->ipcServer->RemoveLayer(GetId());
+    rprRenderParam->renderTagFilter.RemovePrim(GetId());
+    Unpublish();
+
+    HdMesh::Finalize(renderParam);
+}
+
+void HdRprMesh::Unpublish() {
+    if (!m_renderParam) {
+        return;
+    }
+
+    if (m_inTransformHierarchy) {
+        m_renderParam->transformHierarchy.RemoveChild(GetId(), this);
+        m_inTransformHierarchy = false;
+    }
+
+    m_renderParam->publishQueue.Remove(GetId());
+    m_renderParam->backgroundUploads.Cancel(GetId());
+    m_isPublished = false;
+
+    if (m_chunk) {
+        m_renderParam->chunkAggregator.RemovePrim(GetId());
+        m_chunk = nullptr;
+    } else if (m_layer) {
+        // Payloads are referenced by the layer that other render delegates might still hold
+        if (m_renderParam->ipcServer->RemoveLayer(GetId())) {
+            m_renderParam->payloadStore.RemoveLayerPayloads(GetId());
+        }
         m_layer = nullptr;
     }
+    m_hasPayload = false;
 
-    HdMesh::Finalize(renderParam);
+    m_primSpec = SdfPrimSpecHandle();
+    m_geometrySpec = SdfPrimSpecHandle();
+    m_geometryLayer = SdfLayerRefPtr();
+    m_topology = HdMeshTopology();
+    m_adjacency = Hd_VertexAdjacency();
+    m_adjacencyValid = false;
+
+    m_renderParam->SetPrimMemoryUsage(GetId(), 0);
+    m_renderParam = nullptr;
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -15,12 +15,22 @@ limitations under the License.
 #define HDRPR_MESH_H
 
 #include "pxr/imaging/hd/mesh.h"
-#include "pxr/usd/usdGeom/mesh.h"
+#include "pxr/imaging/hd/vertexAdjacency.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "chunkAggregator.h"
+#include "transformHierarchy.h"
+#include "renderTagFilter.h"
+#include "publishQueue.h"
+#include "backgroundUploads.h"
 #include "server.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
-class HdRprMesh final : public HdMesh {
+class HdRprRenderParam;
+
+class HdRprMesh final : public HdMesh, private HdRprIpcTransformHierarchy::Child, private HdRprIpcRenderTagFilter::Prim,
+                        private HdRprIpcPublishQueue::Prim,
+                        private HdRprIpcBackgroundUploads::Prim {
 public:
     HF_MALLOC_TAG_NEW("new HdRprMesh");
 
@@ -42,8 +52,81 @@ protected:
     void _InitRepr(TfToken const& reprName, HdDirtyBits* dirtyBits) override;
 
 private:
-    UsdGeomMesh m_mesh;
+    struct TimeSampling {
+        float frame;
+        // Number of samples over the shutter interval, motion blur is disabled if less than two
+        int motionBlurSamples;
+    };
+
+    /// Points are fetched from the scene delegate at most once per sync.
+    /// Layer specs and payload serialization share the storage of the fetched array, it is never copied
+    class ScenePoints {
+    public:
+        ScenePoints(HdSceneDelegate* sceneDelegate, SdfPath const& id)
+            : m_sceneDelegate(sceneDelegate), m_id(id) {}
+
+        VtValue const& Get();
+        size_t GetSize() { return Get().GetArraySize(); }
+
+    private:
+        HdSceneDelegate* m_sceneDelegate;
+        SdfPath const& m_id;
+        VtValue m_points;
+        bool m_isFetched = false;
+    };
+
+    bool SyncPoints(HdSceneDelegate* sceneDelegate, TimeSampling const& timeSampling, ScenePoints* scenePoints);
+    void SyncTopology(HdSceneDelegate* sceneDelegate);
+    bool SyncNormals(HdSceneDelegate* sceneDelegate, bool computeSmoothNormals);
+    bool SyncUvs(HdSceneDelegate* sceneDelegate);
+    bool SyncTransform(HdSceneDelegate* sceneDelegate, TimeSampling const& timeSampling);
+
+    void SetLocalTransform(GfMatrix4d const& transform, bool isWorldSpace) override;
+
+    void Unpublish() override;
+    void Publish() override;
+
+    void SetPayload(std::vector<std::string> payloadPaths, bool isSplit = false);
+    void SetProxyGeometry(HdSceneDelegate* sceneDelegate, ScenePoints* scenePoints);
+    void OnPayloadsWritten(std::vector<std::string> const& payloadPaths, bool isSplit) override;
+
+private:
+    // Set once the prim is published
+    HdRprRenderParam* m_renderParam = nullptr;
+    TfToken m_renderTag;
+    // False while the initial layer waits in the publish queue
+    bool m_isPublished = false;
+
+    // Prim is authored either into its own layer or into a shared chunk layer
     RprIpcServer::Layer* m_layer = nullptr;
+    HdRprIpcChunkAggregator::Chunk* m_chunk = nullptr;
+    SdfPrimSpecHandle m_primSpec;
+
+    // Points and topology are authored here. It is either m_primSpec or,
+    // when geometry is sent in binary form, a prim of the in-memory layer
+    // that is serialized to a usdc payload referenced by m_primSpec.
+    // The in-memory layer might be released once the payload is written.
+    bool m_useBinaryPayload = false;
+    // Geometry payload is written in background, a proxy box is shown until the first payload is ready
+    bool m_useProxy = false;
+    SdfLayerRefPtr m_geometryLayer;
+    SdfPrimSpecHandle m_geometrySpec;
+    HdMeshTopology m_topology;
+    Hd_VertexAdjacency m_adjacency;
+    bool m_adjacencyValid = false;
+
+    // Payload files are owned by the payload store on behalf of the prim layer,
+    // the proxy box is shown until the first one is referenced
+    bool m_hasPayload = false;
+
+    // Time ranges covered by the time samples sent to the viewer.
+    // Empty when the attribute holds only a default value.
+    // Transform is sent relative to the parent group, see HdRprIpcTransformHierarchy
+    bool m_inTransformHierarchy = false;
+
+    SdfPath m_materialId;
+    // Name of the texture coordinates primvar that is read by the bound material
+    TfToken m_stName;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,227 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "meshSplitter.h"
+#include "layerUtils.h"
+
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/gf/vec2f.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include <algorithm>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+/// Elements of a primvar array that belong to a part:
+/// either mesh vertices referenced by the part or a contiguous range of faces or face vertices
+struct Selection {
+    std::vector<int> const* indices;
+    size_t begin;
+    size_t end;
+};
+
+template <typename T>
+bool TrySlice(VtValue const& value, Selection const& selection, VtValue* slice) {
+    if (!value.IsHolding<VtArray<T>>()) {
+        return false;
+    }
+
+    auto& array = value.UncheckedGet<VtArray<T>>();
+    auto data = array.cdata();
+
+    if (selection.indices) {
+        auto& indices = *selection.indices;
+        VtArray<T> partArray(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (size_t(indices[i]) >= array.size()) {
+                return true;
+            }
+            partArray[i] = data[indices[i]];
+        }
+        *slice = VtValue(std::move(partArray));
+    } else {
+        if (selection.end > array.size()) {
+            return true;
+        }
+        VtArray<T> partArray(selection.end - selection.begin);
+        std::copy(data + selection.begin, data + selection.end, partArray.data());
+        *slice = VtValue(std::move(partArray));
+    }
+    return true;
+}
+
+/// Returns elements of \p value selected by \p selection or an empty value if \p value is not a supported array
+VtValue Slice(VtValue const& value, Selection const& selection) {
+    VtValue slice;
+    TrySlice<GfVec3f>(value, selection, &slice) ||
+    TrySlice<GfVec2f>(value, selection, &slice) ||
+    TrySlice<float>(value, selection, &slice) ||
+    TrySlice<int>(value, selection, &slice);
+    return slice;
+}
+
+TfToken GetToken(SdfPrimSpecHandle const& prim, TfToken const& name) {
+    auto attr = prim->GetLayer()->GetAttributeAtPath(prim->GetPath().AppendProperty(name));
+    if (!attr) {
+        return TfToken();
+    }
+
+    auto value = attr->GetDefaultValue();
+    return value.IsHolding<TfToken>() ? value.UncheckedGet<TfToken>() : TfToken();
+}
+
+VtIntArray GetIntArray(SdfPrimSpecHandle const& prim, TfToken const& name) {
+    auto attr = prim->GetLayer()->GetAttributeAtPath(prim->GetPath().AppendProperty(name));
+    if (!attr) {
+        return VtIntArray();
+    }
+
+    auto value = attr->GetDefaultValue();
+    return value.IsHolding<VtIntArray>() ? value.UncheckedGet<VtIntArray>() : VtIntArray();
+}
+
+} // namespace anonymous
+
+HdRprIpcMeshSplitter::HdRprIpcMeshSplitter(SdfPrimSpecHandle const& mesh, size_t maxPartFaces)
+    : m_mesh(mesh) {
+    if (!m_mesh || maxPartFaces == 0) {
+        return;
+    }
+
+    // Unauthored scheme falls back to catmullClark
+    if (GetToken(m_mesh, UsdGeomTokens->subdivisionScheme) != UsdGeomTokens->none) {
+        return;
+    }
+
+    m_faceVertexCounts = GetIntArray(m_mesh, UsdGeomTokens->faceVertexCounts);
+    m_faceVertexIndices = GetIntArray(m_mesh, UsdGeomTokens->faceVertexIndices);
+
+    size_t numFaceVertices = 0;
+    for (size_t i = 0; i < m_faceVertexCounts.size(); ++i) {
+        if (i % maxPartFaces == 0) {
+            m_partFaceOffsets.push_back(i);
+            m_partFaceVertexOffsets.push_back(numFaceVertices);
+        }
+        numFaceVertices += std::max(m_faceVertexCounts[i], 0);
+    }
+    m_partFaceOffsets.push_back(m_faceVertexCounts.size());
+    m_partFaceVertexOffsets.push_back(numFaceVertices);
+
+    if (numFaceVertices != m_faceVertexIndices.size() ||
+        std::any_of(m_faceVertexIndices.cbegin(), m_faceVertexIndices.cend(), [](int index) { return index < 0; })) {
+        TF_WARN("Invalid topology of %s, the mesh is not split", m_mesh->GetPath().GetText());
+        m_partFaceOffsets.clear();
+        m_partFaceVertexOffsets.clear();
+        return;
+    }
+
+    auto maxIndex = std::max_element(m_faceVertexIndices.cbegin(), m_faceVertexIndices.cend());
+    if (maxIndex != m_faceVertexIndices.cend()) {
+        m_vertexRemap.resize(*maxIndex + 1, -1);
+    }
+}
+
+SdfLayerRefPtr HdRprIpcMeshSplitter::ExtractPart(size_t partIndex) {
+    if (partIndex >= GetNumParts()) {
+        return nullptr;
+    }
+
+    size_t faceBegin = m_partFaceOffsets[partIndex];
+    size_t faceEnd = m_partFaceOffsets[partIndex + 1];
+    size_t faceVertexBegin = m_partFaceVertexOffsets[partIndex];
+    size_t faceVertexEnd = m_partFaceVertexOffsets[partIndex + 1];
+
+    // Part vertices are numbered in the order of their first use
+    auto& partVertices = m_partVertices;
+    partVertices.clear();
+    VtIntArray partFaceVertexIndices(faceVertexEnd - faceVertexBegin);
+    for (size_t i = faceVertexBegin; i < faceVertexEnd; ++i) {
+        int vertex = m_faceVertexIndices[i];
+        if (m_vertexRemap[vertex] < 0) {
+            m_vertexRemap[vertex] = int(partVertices.size());
+            partVertices.push_back(vertex);
+        }
+        partFaceVertexIndices[i - faceVertexBegin] = m_vertexRemap[vertex];
+    }
+    for (int vertex : partVertices) {
+        m_vertexRemap[vertex] = -1;
+    }
+
+    VtIntArray partFaceVertexCounts(faceEnd - faceBegin);
+    std::copy(m_faceVertexCounts.cdata() + faceBegin, m_faceVertexCounts.cdata() + faceEnd, partFaceVertexCounts.data());
+
+    auto layer = SdfLayer::CreateAnonymous(".usdc");
+    auto partPath = m_mesh->GetPath().AppendChild(TfToken(TfStringPrintf("part%zu", partIndex)));
+    auto part = HdRprIpcDefinePrim(layer, partPath, m_mesh->GetTypeName());
+
+    auto srcLayer = m_mesh->GetLayer();
+    for (auto& attr : m_mesh->GetAttributes()) {
+        auto& name = attr->GetNameToken();
+
+        auto partAttr = HdRprIpcCreateAttribute(part, name, attr->GetTypeName(), attr->GetVariability());
+        if (name == UsdGeomTokens->faceVertexCounts) {
+            HdRprIpcSetAttributeValue(partAttr, partFaceVertexCounts);
+            continue;
+        } else if (name == UsdGeomTokens->faceVertexIndices) {
+            HdRprIpcSetAttributeValue(partAttr, partFaceVertexIndices);
+            continue;
+        }
+
+        TfToken interpolation;
+        if (name == UsdGeomTokens->points) {
+            interpolation = UsdGeomTokens->vertex;
+        } else if (attr->HasInfo(UsdGeomTokens->interpolation)) {
+            interpolation = attr->GetInfo(UsdGeomTokens->interpolation).Get<TfToken>();
+            partAttr->SetInfo(UsdGeomTokens->interpolation, VtValue(interpolation));
+        }
+
+        auto getPartValue = [&](VtValue const& value) {
+            if (interpolation == UsdGeomTokens->vertex || interpolation == UsdGeomTokens->varying) {
+                return Slice(value, Selection{&partVertices, 0, 0});
+            } else if (interpolation == UsdGeomTokens->faceVarying) {
+                return Slice(value, Selection{nullptr, faceVertexBegin, faceVertexEnd});
+            } else if (interpolation == UsdGeomTokens->uniform) {
+                return Slice(value, Selection{nullptr, faceBegin, faceEnd});
+            }
+            // Constant primvars and plain attributes are shared by all parts
+            return value;
+        };
+
+        auto times = srcLayer->ListTimeSamplesForPath(attr->GetPath());
+        if (times.empty()) {
+            auto partValue = getPartValue(attr->GetDefaultValue());
+            if (partValue.IsEmpty()) {
+                TF_WARN("Failed to split %s attribute", attr->GetPath().GetText());
+                part->RemoveProperty(partAttr);
+                continue;
+            }
+            HdRprIpcSetAttributeValue(partAttr, partValue);
+        } else {
+            SdfTimeSampleMap timeSamples;
+            for (double time : times) {
+                VtValue value;
+                srcLayer->QueryTimeSample(attr->GetPath(), time, &value);
+                timeSamples[time] = getPartValue(value);
+            }
+            HdRprIpcSetAttributeTimeSamples(partAttr, std::move(timeSamples));
+        }
+    }
+
+    return layer;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,59 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_MESH_SPLITTER_H
+#define HDRPR_MESH_SPLITTER_H
+
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/base/vt/array.h"
+
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Splits a mesh into parts of at most maxPartFaces faces.
+/// Each part is extracted into its own layer as a child Mesh prim of the source mesh path,
+/// so the viewer reassembles the mesh by composing all part layers. The prim at the source
+/// mesh path must not be a gprim then, as gprims can not be nested. Parts are extracted
+/// one at a time which bounds memory used by the serialization of a huge mesh.
+/// Subdivision surfaces are not split: every part would be refined on its own and crack along the cuts.
+/// Vertex primvars are sliced per part, so normals computed for the whole mesh match along the cuts.
+class HdRprIpcMeshSplitter {
+public:
+    HdRprIpcMeshSplitter(SdfPrimSpecHandle const& mesh, size_t maxPartFaces);
+
+    size_t GetNumParts() const { return m_partFaceOffsets.empty() ? 0 : m_partFaceOffsets.size() - 1; }
+
+    /// Returns a layer with \p partIndex part or nullptr if the mesh can not be split
+    SdfLayerRefPtr ExtractPart(size_t partIndex);
+
+private:
+    SdfPrimSpecHandle m_mesh;
+    VtIntArray m_faceVertexCounts;
+    VtIntArray m_faceVertexIndices;
+
+    // Offsets of the first face and the first face vertex of every part plus the total counts
+    std::vector<size_t> m_partFaceOffsets;
+    std::vector<size_t> m_partFaceVertexOffsets;
+
+    // Maps mesh vertices to part vertices, reset after every extraction
+    std::vector<int> m_vertexRemap;
+    // Mesh vertices of the extracted part, the storage is reused by all parts
+    std::vector<int> m_partVertices;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_MESH_SPLITTER_H
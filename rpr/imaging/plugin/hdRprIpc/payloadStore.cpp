@@ -0,0 +1,425 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "payloadStore.h"
+
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/arch/hash.h"
+#include "pxr/base/arch/systemInfo.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/envSetting.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/gf/vec2f.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/usd/sdf/attributeSpec.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(HDRPRIPC_PAYLOAD_DIR, "",
+    "Directory where binary geometry payloads are written. Should be memory backed and accessible by the viewer.");
+TF_DEFINE_ENV_SETTING(HDRPRIPC_PAYLOAD_CACHE_DIR, "",
+    "Directory where binary geometry payloads are cached across sessions by their content hash. Empty disables the cache.");
+TF_DEFINE_ENV_SETTING(HDRPRIPC_PAYLOAD_CACHE_MAX_SIZE, 4096,
+    "Size of the payload cache in megabytes after which least recently used payloads are removed.");
+
+namespace {
+
+std::string GetPayloadBaseDir() {
+    std::string dir = TfGetEnvSetting(HDRPRIPC_PAYLOAD_DIR);
+    if (!dir.empty()) {
+        return dir;
+    }
+
+#ifdef __linux__
+    if (TfIsDir("/dev/shm")) {
+        return "/dev/shm";
+    }
+#endif // __linux__
+
+    return ArchGetTmpDir();
+}
+
+// Bump when the payload layout changes so that stale cache entries are not picked up
+constexpr uint64_t kCacheVersion = 2;
+
+// Hash of the layer structure, a cache hit is accepted only if it matches too
+const std::string kStructureHashKey("rprIpc:structureHash");
+
+/// Content hash names the cache file, structure hash of paths, types and array sizes
+/// is stored in it to tell a name collision from a hit. Both are computed in one traversal
+/// and only the content hash reads the array data.
+/// Hashes must be stable across runs, so nothing is hashed through VtValue::GetHash,
+/// it hashes tokens by their pointers
+struct LayerHash {
+    uint64_t content;
+    uint64_t structure;
+
+    void AddBytes(void const* data, size_t size) {
+        content = ArchHash64(static_cast<const char*>(data), size, content);
+    }
+
+    void AddString(std::string const& string) {
+        AddBytes(string.c_str(), string.size() + 1);
+        structure = ArchHash64(string.c_str(), string.size() + 1, structure);
+    }
+
+    template <typename T>
+    bool AddPod(VtValue const& value) {
+        if (!value.IsHolding<T>()) {
+            return false;
+        }
+        AddBytes(&value.UncheckedGet<T>(), sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    bool AddArray(VtValue const& value) {
+        if (!value.IsHolding<VtArray<T>>()) {
+            return false;
+        }
+
+        // Arrays are hashed as raw memory, it is much faster than per element hashing
+        auto& array = value.UncheckedGet<VtArray<T>>();
+        uint64_t size = array.size();
+        structure = ArchHash64(reinterpret_cast<const char*>(&size), sizeof(size), structure);
+        AddBytes(array.cdata(), array.size() * sizeof(T));
+        return true;
+    }
+
+    /// Returns false if \p value has no hash that is stable across runs
+    bool AddValue(VtValue const& value) {
+        if (value.IsEmpty()) {
+            AddString(std::string());
+            return true;
+        } else if (value.IsHolding<TfToken>()) {
+            AddString(value.UncheckedGet<TfToken>().GetString());
+            return true;
+        } else if (value.IsHolding<std::string>()) {
+            AddString(value.UncheckedGet<std::string>());
+            return true;
+        }
+
+        if (AddArray<GfVec3f>(value) ||
+            AddArray<GfVec2f>(value) ||
+            AddArray<float>(value) ||
+            AddArray<int>(value) ||
+            AddPod<float>(value) ||
+            AddPod<double>(value) ||
+            AddPod<int>(value) ||
+            AddPod<bool>(value)) {
+            return true;
+        }
+
+        TF_CODING_ERROR("Payload value of type %s has no hash that is stable across runs", value.GetTypeName().c_str());
+        return false;
+    }
+};
+
+/// Hashes everything a geometry payload might contain: prims, attributes, their values and time samples.
+/// Returns false if the layer holds a value that can not be hashed
+bool HashLayer(SdfLayerHandle const& layer, LayerHash* hash) {
+    hash->content = kCacheVersion;
+    hash->structure = kCacheVersion;
+
+    bool isHashed = true;
+    layer->Traverse(SdfPath::AbsoluteRootPath(), [&layer, hash, &isHashed](SdfPath const& path) {
+        if (!isHashed) {
+            return;
+        }
+        hash->AddString(path.GetString());
+
+        if (auto prim = layer->GetPrimAtPath(path)) {
+            hash->AddString(prim->GetTypeName().GetString());
+        } else if (auto attr = layer->GetAttributeAtPath(path)) {
+            hash->AddString(attr->GetTypeName().GetAsToken().GetString());
+            isHashed &= hash->AddValue(attr->GetInfo(UsdGeomTokens->interpolation));
+            isHashed &= hash->AddValue(attr->GetDefaultValue());
+            for (double time : layer->ListTimeSamplesForPath(path)) {
+                VtValue value;
+                layer->QueryTimeSample(path, time, &value);
+                hash->AddBytes(&time, sizeof(time));
+                isHashed &= hash->AddValue(value);
+            }
+        }
+    });
+
+    return isHashed;
+}
+
+bool HasStructureHash(std::string const& path, std::string const& structureHash) {
+    // Only the layer metadata is read
+    auto layer = SdfLayer::OpenAsAnonymous(path, true);
+    if (!layer) {
+        return false;
+    }
+
+    auto customData = layer->GetCustomLayerData();
+    auto it = customData.find(kStructureHashKey);
+    return it != customData.end() && it->second.IsHolding<std::string>() && it->second.UncheckedGet<std::string>() == structureHash;
+}
+
+} // namespace anonymous
+
+HdRprIpcPayloadStore::HdRprIpcPayloadStore()
+    : m_counter(0) {
+    m_dir = ArchMakeTmpSubdir(GetPayloadBaseDir(), "hdRprIpc");
+    if (m_dir.empty()) {
+        TF_RUNTIME_ERROR("Failed to create payload directory in %s", GetPayloadBaseDir().c_str());
+    }
+
+    std::string cacheDir = TfGetEnvSetting(HDRPRIPC_PAYLOAD_CACHE_DIR);
+    if (!cacheDir.empty()) {
+        if (TfIsDir(cacheDir) || TfMakeDirs(cacheDir, -1, true)) {
+            m_cacheDir = TfAbsPath(cacheDir);
+            m_cacheMaxSize = size_t(std::max(TfGetEnvSetting(HDRPRIPC_PAYLOAD_CACHE_MAX_SIZE), 0)) << 20;
+
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            PruneCache();
+        } else {
+            TF_RUNTIME_ERROR("Failed to create payload cache directory %s", cacheDir.c_str());
+        }
+    }
+}
+
+HdRprIpcPayloadStore::~HdRprIpcPayloadStore() {
+    if (!m_dir.empty()) {
+        TfRmTree(m_dir);
+    }
+}
+
+std::string HdRprIpcPayloadStore::Write(SdfLayerHandle const& layer) {
+    LayerHash hash;
+    if (!m_cacheDir.empty() && HashLayer(layer, &hash)) {
+        return WriteCached(layer, hash.content, hash.structure);
+    }
+    return WriteUncached(layer);
+}
+
+std::string HdRprIpcPayloadStore::WriteLayerPayload(SdfPath const& layerPath, SdfLayerHandle const& layer) {
+    LayerHash hash;
+    if (!HashLayer(layer, &hash)) {
+        return WriteUncached(layer);
+    }
+    auto payloadHash = std::make_pair(hash.content, hash.structure);
+
+    {
+        std::lock_guard<std::mutex> lock(m_layerPayloadsMutex);
+        auto it = m_layerPayloads.find(layerPath);
+        if (it != m_layerPayloads.end() && it->second.paths.size() == 1) {
+            auto hashIt = m_payloadHashes.find(it->second.paths[0]);
+            if (hashIt != m_payloadHashes.end() && hashIt->second == payloadHash) {
+                return it->second.paths[0];
+            }
+        }
+    }
+
+    auto path = m_cacheDir.empty() ? WriteUncached(layer) : WriteCached(layer, hash.content, hash.structure);
+    if (!path.empty()) {
+        std::lock_guard<std::mutex> lock(m_layerPayloadsMutex);
+        m_payloadHashes[path] = payloadHash;
+    }
+    return path;
+}
+
+std::string HdRprIpcPayloadStore::WriteUncached(SdfLayerHandle const& layer) {
+    if (m_dir.empty()) {
+        return std::string();
+    }
+
+    // Unique name on each write so that the viewer never picks up a stale layer from its registry
+    auto path = TfStringCatPaths(m_dir, TfStringPrintf("%llu.usdc", static_cast<unsigned long long>(m_counter++)));
+    if (!layer->Export(path)) {
+        TF_RUNTIME_ERROR("Failed to write payload %s", path.c_str());
+        return std::string();
+    }
+
+    return path;
+}
+
+std::string HdRprIpcPayloadStore::WriteCached(SdfLayerHandle const& layer, uint64_t contentHash, uint64_t structureHash) {
+    // Name depends only on the content, the same content never gets a stale file
+    auto path = TfStringCatPaths(m_cacheDir, TfStringPrintf("%016llx.usdc", static_cast<unsigned long long>(contentHash)));
+    auto structureHashString = TfStringPrintf("%016llx", static_cast<unsigned long long>(structureHash));
+    if (TfIsFile(path)) {
+        if (!HasStructureHash(path, structureHashString)) {
+            // The name collides with a different content, such a payload is not cached
+            return WriteUncached(layer);
+        }
+
+        // Modification time orders the least recently used files for pruning
+        TfTouchFile(path, false);
+
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        m_cachedPaths.insert(path);
+        return path;
+    }
+
+    // The structure hash is stored in the file so that later hits can be verified without reading the arrays
+    auto customData = layer->GetCustomLayerData();
+    auto cachedCustomData = customData;
+    cachedCustomData[kStructureHashKey] = VtValue(structureHashString);
+    layer->SetCustomLayerData(cachedCustomData);
+
+    // Written under a temporary name and renamed so that concurrent sessions never read a partially written file
+    auto tmpPath = TfStringCatPaths(m_cacheDir, TfStringPrintf("tmp%d_%llu.usdc", ArchGetProcessId(), static_cast<unsigned long long>(m_counter++)));
+    bool isExported = layer->Export(tmpPath);
+    layer->SetCustomLayerData(customData);
+    if (!isExported) {
+        TF_RUNTIME_ERROR("Failed to write payload %s", tmpPath.c_str());
+        TfDeleteFile(tmpPath);
+        return std::string();
+    }
+
+    auto fileSize = ArchGetFileLength(tmpPath.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        // Another session might have cached the same content in the meantime
+        TfDeleteFile(tmpPath);
+        if (!TfIsFile(path)) {
+            TF_RUNTIME_ERROR("Failed to write payload %s", path.c_str());
+            return std::string();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_cachedPaths.insert(path);
+    m_cacheSize += fileSize > 0 ? size_t(fileSize) : 0;
+    if (m_cacheSize > m_cacheMaxSize) {
+        PruneCache();
+    }
+    return path;
+}
+
+void HdRprIpcPayloadStore::PruneCache() {
+    struct CacheFile {
+        std::string path;
+        double modificationTime;
+        size_t size;
+    };
+
+    std::vector<std::string> dirNames;
+    std::vector<std::string> fileNames;
+    if (!TfReadDir(m_cacheDir, &dirNames, &fileNames, nullptr)) {
+        return;
+    }
+
+    std::vector<CacheFile> files;
+    m_cacheSize = 0;
+    for (auto& fileName : fileNames) {
+        // Temporary files of concurrent writes are not cache entries yet
+        if (!TfStringEndsWith(fileName, ".usdc") || TfStringStartsWith(fileName, "tmp")) {
+            continue;
+        }
+
+        CacheFile file;
+        file.path = TfStringCatPaths(m_cacheDir, fileName);
+        auto fileSize = ArchGetFileLength(file.path.c_str());
+        if (fileSize < 0 || !ArchGetModificationTime(file.path.c_str(), &file.modificationTime)) {
+            continue;
+        }
+        file.size = size_t(fileSize);
+        m_cacheSize += file.size;
+        files.push_back(std::move(file));
+    }
+
+    std::sort(files.begin(), files.end(), [](CacheFile const& lhs, CacheFile const& rhs) {
+        return lhs.modificationTime < rhs.modificationTime;
+    });
+    for (auto& file : files) {
+        if (m_cacheSize <= m_cacheMaxSize) {
+            break;
+        }
+        // Payloads of this session might be referenced by the viewer
+        if (m_cachedPaths.count(file.path)) {
+            continue;
+        }
+        if (TfDeleteFile(file.path)) {
+            m_cacheSize -= file.size;
+        }
+    }
+}
+
+void HdRprIpcPayloadStore::Remove(std::string const& path) {
+    if (path.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_layerPayloadsMutex);
+        m_payloadHashes.erase(path);
+    }
+
+    {
+        // Cached payloads outlive the session and might be shared by several prims
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (m_cachedPaths.count(path)) {
+            return;
+        }
+    }
+
+    TfDeleteFile(path);
+}
+
+void HdRprIpcPayloadStore::SetLayerPayloads(SdfPath const& layerPath, std::vector<std::string> paths) {
+    std::vector<std::string> removedPaths;
+    {
+        std::lock_guard<std::mutex> lock(m_layerPayloadsMutex);
+
+        auto& payloads = m_layerPayloads[layerPath];
+        auto isListed = [&payloads, &paths](std::string const& path) {
+            return std::find(paths.begin(), paths.end(), path) != paths.end() ||
+                std::find(payloads.paths.begin(), payloads.paths.end(), path) != payloads.paths.end();
+        };
+        for (auto& path : payloads.prevPaths) {
+            if (!isListed(path)) {
+                removedPaths.push_back(std::move(path));
+            }
+        }
+        payloads.prevPaths = std::move(payloads.paths);
+        payloads.paths = std::move(paths);
+    }
+
+    for (auto& path : removedPaths) {
+        Remove(path);
+    }
+}
+
+void HdRprIpcPayloadStore::RemoveLayerPayloads(SdfPath const& layerPath) {
+    LayerPayloads payloads;
+    {
+        std::lock_guard<std::mutex> lock(m_layerPayloadsMutex);
+
+        auto it = m_layerPayloads.find(layerPath);
+        if (it == m_layerPayloads.end()) {
+            return;
+        }
+        payloads = std::move(it->second);
+        m_layerPayloads.erase(it);
+    }
+
+    for (auto& path : payloads.paths) {
+        Remove(path);
+    }
+    for (auto& path : payloads.prevPaths) {
+        Remove(path);
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,96 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_PAYLOAD_STORE_H
+#define HDRPR_PAYLOAD_STORE_H
+
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <set>
+#include <map>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Stores heavy geometry data as binary crate (usdc) files in a memory backed
+/// directory shared with the viewer. Mesh layers reference these files instead
+/// of carrying large arrays, so neither side has to format or parse them as text.
+///
+/// When HDRPRIPC_PAYLOAD_CACHE_DIR is set, payloads are named by the hash of their
+/// content and kept in that directory across sessions. A layer whose payload is
+/// already cached is not serialized again and the viewer loads the cached file.
+/// Least recently used files are pruned once the cache exceeds HDRPRIPC_PAYLOAD_CACHE_MAX_SIZE.
+class HdRprIpcPayloadStore {
+public:
+    HdRprIpcPayloadStore();
+    ~HdRprIpcPayloadStore();
+
+    HdRprIpcPayloadStore(const HdRprIpcPayloadStore&) = delete;
+    HdRprIpcPayloadStore& operator =(const HdRprIpcPayloadStore&) = delete;
+
+    /// Serializes \p layer with the binary crate format.
+    /// Returns path to the written file or an empty string in case of failure.
+    std::string Write(SdfLayerHandle const& layer);
+
+    /// Serializes \p layer as the payload of the layer at \p layerPath.
+    /// Render delegates of a session sync the same prims, so when the current payload of \p layerPath
+    /// has been written by this function from equal content, it is returned instead of serializing \p layer again
+    std::string WriteLayerPayload(SdfPath const& layerPath, SdfLayerHandle const& layer);
+
+    /// Removes a file previously returned by Write, cached files are kept
+    void Remove(std::string const& path);
+
+    /// Hands files returned by Write over to the layer at \p layerPath.
+    /// Render delegates of a session share the layer, so its payloads must outlive any single prim.
+    /// Payloads replaced by the previous call are removed now, the ones replaced by this call
+    /// are kept until the next one so that the viewer has a chance to switch to the new files.
+    /// Files that are still listed are never removed, so parts of a split mesh can be handed over one by one
+    void SetLayerPayloads(SdfPath const& layerPath, std::vector<std::string> paths);
+
+    /// Removes all payloads of \p layerPath, must be called once the last user removed the layer
+    void RemoveLayerPayloads(SdfPath const& layerPath);
+
+private:
+    std::string WriteUncached(SdfLayerHandle const& layer);
+    std::string WriteCached(SdfLayerHandle const& layer, uint64_t contentHash, uint64_t structureHash);
+    // Removes least recently used cache files, m_cacheMutex must be held
+    void PruneCache();
+
+private:
+    std::string m_dir;
+    std::string m_cacheDir;
+    std::atomic<uint64_t> m_counter;
+
+    std::mutex m_cacheMutex;
+    // Cached files handed out by this store, they are never pruned or removed
+    std::set<std::string> m_cachedPaths;
+    size_t m_cacheSize = 0;
+    size_t m_cacheMaxSize = 0;
+
+    struct LayerPayloads {
+        std::vector<std::string> paths;
+        std::vector<std::string> prevPaths;
+    };
+    std::mutex m_layerPayloadsMutex;
+    std::map<SdfPath, LayerPayloads> m_layerPayloads;
+    // Content and structure hashes of files written by WriteLayerPayload
+    std::map<std::string, std::pair<uint64_t, uint64_t>> m_payloadHashes;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_PAYLOAD_STORE_H
@@ -0,0 +1,119 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "publishQueue.h"
+
+#include "pxr/base/gf/vec4d.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr double kFullScreenArea = 4.0;
+constexpr double kOffScreenPriority = -1.0;
+
+/// Returns area of \p worldExtent projected into normalized device coordinates
+double GetScreenArea(GfRange3d const& worldExtent, GfMatrix4d const& viewProjectionMatrix) {
+    if (worldExtent.IsEmpty()) {
+        // Unknown extent, publish after visible prims but before off-screen ones
+        return 0.0;
+    }
+
+    GfVec3d ndcMin(std::numeric_limits<double>::max());
+    GfVec3d ndcMax(std::numeric_limits<double>::lowest());
+    bool isBehindCamera = false;
+    bool isInFrontOfCamera = false;
+
+    for (int i = 0; i < 8; ++i) {
+        auto corner = worldExtent.GetCorner(i);
+        auto clip = GfVec4d(corner[0], corner[1], corner[2], 1.0) * viewProjectionMatrix;
+        if (clip[3] <= 0.0) {
+            isBehindCamera = true;
+            continue;
+        }
+        isInFrontOfCamera = true;
+
+        auto ndc = GfVec3d(clip[0], clip[1], clip[2]) / clip[3];
+        for (int j = 0; j < 3; ++j) {
+            ndcMin[j] = std::min(ndcMin[j], ndc[j]);
+            ndcMax[j] = std::max(ndcMax[j], ndc[j]);
+        }
+    }
+
+    if (!isInFrontOfCamera) {
+        return kOffScreenPriority;
+    }
+    if (isBehindCamera) {
+        // Extent surrounds the camera
+        return kFullScreenArea;
+    }
+
+    for (int j = 0; j < 3; ++j) {
+        if (ndcMax[j] < -1.0 || ndcMin[j] > 1.0) {
+            return kOffScreenPriority;
+        }
+    }
+
+    auto width = std::min(ndcMax[0], 1.0) - std::max(ndcMin[0], -1.0);
+    auto height = std::min(ndcMax[1], 1.0) - std::max(ndcMin[1], -1.0);
+    return width * height;
+}
+
+} // namespace anonymous
+
+void HdRprIpcPublishQueue::Push(SdfPath const& id, GfRange3d const& worldExtent, size_t numPoints, Prim* prim) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[id] = {worldExtent, numPoints, prim};
+}
+
+void HdRprIpcPublishQueue::Remove(SdfPath const& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(id);
+}
+
+bool HdRprIpcPublishQueue::Publish(GfMatrix4d const& viewProjectionMatrix, size_t pointsBudget) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.empty()) {
+        return false;
+    }
+
+    std::vector<std::pair<double, std::map<SdfPath, Entry>::iterator>> queue;
+    queue.reserve(m_entries.size());
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        queue.emplace_back(GetScreenArea(it->second.worldExtent, viewProjectionMatrix), it);
+    }
+    std::stable_sort(queue.begin(), queue.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.first > rhs.first;
+    });
+
+    size_t numPublishedPoints = 0;
+    for (auto& entry : queue) {
+        auto it = entry.second;
+        if (numPublishedPoints && numPublishedPoints + it->second.numPoints > pointsBudget) {
+            break;
+        }
+        numPublishedPoints += it->second.numPoints;
+
+        it->second.prim->Publish();
+        m_entries.erase(it);
+    }
+
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,68 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_PUBLISH_QUEUE_H
+#define HDRPR_PUBLISH_QUEUE_H
+
+#include "pxr/base/gf/matrix4d.h"
+#include "pxr/base/gf/range3d.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <mutex>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Defers initial publishing of prims and streams them by their priority:
+/// prims that cover larger area of the screen go first, off-screen prims go last.
+/// The queue is drained by the render pass with the camera of the pass
+/// and a budget that limits the amount of geometry sent per execution.
+class HdRprIpcPublishQueue {
+public:
+    class Prim {
+    public:
+        virtual ~Prim() = default;
+
+        virtual void Publish() = 0;
+    };
+
+    HdRprIpcPublishQueue() = default;
+    ~HdRprIpcPublishQueue() = default;
+
+    HdRprIpcPublishQueue(const HdRprIpcPublishQueue&) = delete;
+    HdRprIpcPublishQueue& operator =(const HdRprIpcPublishQueue&) = delete;
+
+    /// Queues \p prim or updates its queued entry
+    void Push(SdfPath const& id, GfRange3d const& worldExtent, size_t numPoints, Prim* prim);
+    void Remove(SdfPath const& id);
+
+    /// Publishes queued prims in priority order until \p pointsBudget is spent.
+    /// At least one prim is published per call so that the queue always drains.
+    /// Returns true if anything was published
+    bool Publish(GfMatrix4d const& viewProjectionMatrix, size_t pointsBudget);
+
+private:
+    struct Entry {
+        GfRange3d worldExtent;
+        size_t numPoints;
+        Prim* prim;
+    };
+
+    std::mutex m_mutex;
+    std::map<SdfPath, Entry> m_entries;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_PUBLISH_QUEUE_H
@@ -12,9 +12,14 @@ limitations under the License.
 ************************************************************************/
 
 #include "renderBuffer.h"
+#include "renderParam.h"
 
 #include "pxr/imaging/hd/sceneDelegate.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 HdRprRenderBuffer::HdRprRenderBuffer(SdfPath const& id)
@@ -31,6 +36,7 @@ void HdRprRenderBuffer::Sync(HdSceneDelegate* sceneDelegate,
 }
 
 void HdRprRenderBuffer::Finalize(HdRenderParam* renderParam) {
+    static_cast<HdRprRenderParam*>(renderParam)->RemoveAovBuffer(this);
     HdRenderBuffer::Finalize(renderParam);
 }
 
@@ -45,15 +51,12 @@ bool HdRprRenderBuffer::Allocate(GfVec3i const& dimensions,
         return false;
     }
 
-    _Deallocate();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DeallocateImpl();
 
     m_width = dimensions[0];
     m_height = dimensions[1];
-    if (m_allowArbitraryFormat) {
-        m_format = format;
-    } else {
-        m_format = HdFormatFloat32Vec4;
-    }
+    m_format = format;
     size_t dataByteSize = m_width * m_height * HdDataSizeOfFormat(m_format);
     m_mappedBuffer.resize(dataByteSize, 0);
 
@@ -61,6 +64,11 @@ bool HdRprRenderBuffer::Allocate(GfVec3i const& dimensions,
 }
 
 void HdRprRenderBuffer::_Deallocate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DeallocateImpl();
+}
+
+void HdRprRenderBuffer::DeallocateImpl() {
     TF_VERIFY(!IsMapped());
 
     m_width = 0u;
@@ -101,4 +109,35 @@ void HdRprRenderBuffer::SetConverged(bool converged) {
     return m_isConverged.store(converged);
 }
 
+bool HdRprRenderBuffer::BlitTile(int x, int y, int width, int height, uint8_t const* data, size_t dataSize) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t pixelSize = HdDataSizeOfFormat(m_format);
+    size_t srcRowSize = size_t(width) * pixelSize;
+    if (!pixelSize || dataSize != srcRowSize * size_t(height)) {
+        return false;
+    }
+
+    // Computed in 64 bits, the tile rect comes from the viewer and might overflow int
+    int x0 = std::max(x, 0);
+    int y0 = std::max(y, 0);
+    int x1 = int(std::min(int64_t(x) + width, int64_t(m_width)));
+    int y1 = int(std::min(int64_t(y) + height, int64_t(m_height)));
+    if (x0 >= x1 || y0 >= y1) {
+        return true;
+    }
+
+    size_t rowSize = (x1 - x0) * pixelSize;
+    for (int row = y0; row < y1; ++row) {
+        auto src = data + (row - y) * srcRowSize + (x0 - x) * pixelSize;
+        auto dst = m_mappedBuffer.data() + (size_t(row) * m_width + x0) * pixelSize;
+        std::memcpy(dst, src, rowSize);
+    }
+    return true;
+}
+
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -16,6 +16,10 @@ limitations under the License.
 
 #include "pxr/imaging/hd/renderBuffer.h"
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 class HdRprRenderBuffer final : public HdRenderBuffer {
@@ -55,14 +59,25 @@ public:
 
     void SetConverged(bool converged);
 
+    /// Copies \p width x \p height block of tightly packed pixels in the format of the buffer to (\p x, \p y).
+    /// The block is clipped to the buffer. Called from the server thread, so the buffer might be
+    /// reallocated concurrently. Returns false if \p dataSize does not match the current format
+    bool BlitTile(int x, int y, int width, int height, uint8_t const* data, size_t dataSize);
+
 protected:
     void _Deallocate() override;
 
 private:
+    // m_mutex must be held
+    void DeallocateImpl();
+
+private:
+    // Guards the size, the format and the storage against BlitTile
+    std::mutex m_mutex;
+
     uint32_t m_width = 0u;
     uint32_t m_height = 0u;
     HdFormat m_format = HdFormat::HdFormatInvalid;
-    bool m_allowArbitraryFormat;
 
     std::vector<uint8_t> m_mappedBuffer;
     std::atomic<int> m_numMappers;
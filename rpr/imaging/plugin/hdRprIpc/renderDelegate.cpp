@@ -15,13 +15,20 @@ limitations under the License.
 
 #include "renderPass.h"
 #include "mesh.h"
-// #include "light.h"
-// #include "material.h"
+#include "light.h"
+#include "camera.h"
+#include "material.h"
 #include "renderBuffer.h"
 
 #include <pxr/imaging/hd/instancer.h>
-#include <pxr/imaging/hd/camera.h>
-
+#include <pxr/imaging/hd/tokens.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/base/tf/stringUtils.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
@@ -29,18 +36,36 @@ limitations under the License.
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+TF_DEFINE_PUBLIC_TOKENS(HdRprIpcAovTokens, HDRPRIPC_AOV_TOKENS);
+TF_DEFINE_PUBLIC_TOKENS(HdRprIpcRenderSettingsTokens, HDRPRIPC_RENDER_SETTINGS_TOKENS);
+
+namespace {
+
+// Parses a decimal integer in [minValue, maxValue], returns false if \p token is not one
+bool ParseInt(std::string const& token, long minValue, long maxValue, int* value) {
+    errno = 0;
+    char* end = nullptr;
+    long result = std::strtol(token.c_str(), &end, 10);
+    if (end == token.c_str() || *end != '\0' || errno == ERANGE || result < minValue || result > maxValue) {
+        return false;
+    }
+    *value = int(result);
+    return true;
+}
+
+} // namespace anonymous
+
 const TfTokenVector HdRprIpcDelegate::SUPPORTED_RPRIM_TYPES = {
     HdPrimTypeTokens->mesh,
 };
 
 const TfTokenVector HdRprIpcDelegate::SUPPORTED_SPRIM_TYPES = {
     HdPrimTypeTokens->camera,
-    // HdPrimTypeTokens->material,
-    // HdPrimTypeTokens->rectLight,
-    // HdPrimTypeTokens->sphereLight,
-    // HdPrimTypeTokens->cylinderLight,
-    // HdPrimTypeTokens->diskLight,
-    // HdPrimTypeTokens->distantLight,
+    HdPrimTypeTokens->material,
+    HdPrimTypeTokens->rectLight,
+    HdPrimTypeTokens->sphereLight,
+    HdPrimTypeTokens->cylinderLight,
+    HdPrimTypeTokens->diskLight,
 };
 
 const TfTokenVector HdRprIpcDelegate::SUPPORTED_BPRIM_TYPES = {
@@ -48,19 +73,65 @@ const TfTokenVector HdRprIpcDelegate::SUPPORTED_BPRIM_TYPES = {
 };
 
 HdRprIpcDelegate::HdRprIpcDelegate(HdRenderSettingsMap const& renderSettings)
-    : m_ipcServer(std::make_unique<RprIpcServer>(this))
-    , m_renderParam(std::make_unique<HdRprRenderParam>(m_ipcServer.get(), &m_renderThread)) {
+    : m_session(HdRprIpcSession::Acquire())
+    , m_viewportPath(m_session->AddViewport(this))
+    , m_renderParam(std::make_unique<HdRprRenderParam>(m_session.get(), m_viewportPath, &m_renderThread, this)) {
+    // Time code the scene is currently synced at, set by the host application
+    m_settingDescriptors.push_back({"Frame", HdRprIpcRenderSettingsTokens->frame, VtValue(0.0f)});
+    // Number of transform and points samples over the shutter interval (1 disables motion blur)
+    m_settingDescriptors.push_back({"Motion Blur Samples", HdRprIpcRenderSettingsTokens->motionBlurSamples, VtValue(1)});
+    // Format heavy geometry data is sent in: "usda" keeps it in the mesh layer,
+    // "usdc" writes it to a binary crate payload that the mesh layer references
+    m_settingDescriptors.push_back({"Geometry Format", HdRprIpcRenderSettingsTokens->geometryFormat, VtValue(TfToken("usda"))});
+    // Release client-side copy of geometry once its binary payload is written
+    m_settingDescriptors.push_back({"Drop Sent Geometry", HdRprIpcRenderSettingsTokens->dropSentGeometry, VtValue(false)});
+    // Meshes with at most this number of points are packed into shared chunk layers (0 disables aggregation)
+    m_settingDescriptors.push_back({"Aggregation Max Points", HdRprIpcRenderSettingsTokens->aggregationMaxPoints, VtValue(0)});
+    // Maximum number of prims in one chunk layer
+    m_settingDescriptors.push_back({"Aggregation Chunk Size", HdRprIpcRenderSettingsTokens->aggregationChunkSize, VtValue(1024)});
+    // Where smooth normals are generated for meshes without authored normals:
+    // "viewer" sends no normals, "client" computes and sends them
+    m_settingDescriptors.push_back({"Normals Source", HdRprIpcRenderSettingsTokens->normalsSource, VtValue(TfToken("viewer"))});
+    // Send mesh transforms relative to their parent prim so that moving a parent is a single edit
+    m_settingDescriptors.push_back({"Transform Hierarchy", HdRprIpcRenderSettingsTokens->transformHierarchy, VtValue(false)});
+    // Maximum number of points of newly created meshes sent per render pass execution, largest on-screen meshes go first
+    // (0 sends meshes as soon as they are synced)
+    m_settingDescriptors.push_back({"Streaming Points Budget", HdRprIpcRenderSettingsTokens->streamingPointsBudget, VtValue(0)});
+    // Meshes with at least this number of points are shown as a bounding box proxy
+    // while their binary payload is written in background (0 disables proxies)
+    m_settingDescriptors.push_back({"Proxy Min Points", HdRprIpcRenderSettingsTokens->proxyMinPoints, VtValue(0)});
+    // Polygonal meshes with more faces are written in background as separate parts of at most this number of faces.
+    // Parts are shown as soon as they are written, a new edit of the mesh cancels the remaining parts (0 disables splitting)
+    m_settingDescriptors.push_back({"Upload Part Faces", HdRprIpcRenderSettingsTokens->uploadPartFaces, VtValue(0)});
+    // Number of render server processes the frame is split between, every server renders one horizontal band
+    m_settingDescriptors.push_back({"Render Servers", HdRprIpcRenderSettingsTokens->renderServers, VtValue(1)});
+    // Render tags whose prims are sent before the first render pass executes and reports the tags it draws,
+    // afterwards the union of tags of all render passes is sent (empty sends all tags)
+    m_settingDescriptors.push_back({"Render Tags", HdRprIpcRenderSettingsTokens->renderTags, VtValue(TfTokenVector{HdRenderTagTokens->geometry, HdRenderTagTokens->render})});
+    _PopulateDefaultSettings(m_settingDescriptors);
+
     for (auto& entry : renderSettings) {
         SetRenderSetting(entry.first, entry.second);
     }
 
+    auto renderTags = GetRenderSetting(HdRprIpcRenderSettingsTokens->renderTags);
+    if (renderTags.IsHolding<TfTokenVector>()) {
+        m_renderParam->renderTagFilter.SetDefaultRenderTags(renderTags.UncheckedGet<TfTokenVector>());
+    } else if (renderTags.IsHolding<VtTokenArray>()) {
+        auto& renderTagArray = renderTags.UncheckedGet<VtTokenArray>();
+        m_renderParam->renderTagFilter.SetDefaultRenderTags(TfTokenVector(renderTagArray.begin(), renderTagArray.end()));
+    }
+
     m_renderThread.SetRenderCallback([this]() {
         // no-op
     });
     m_renderThread.StartThread();
 }
 
-HdRprIpcDelegate::~HdRprIpcDelegate() = default;
+HdRprIpcDelegate::~HdRprIpcDelegate() {
+    m_session->EndSync(this);
+    m_session->RemoveViewport(m_viewportPath);
+}
 
 HdRenderParam* HdRprIpcDelegate::GetRenderParam() const {
     return m_renderParam.get();
@@ -69,6 +140,18 @@ HdRenderParam* HdRprIpcDelegate::GetRenderParam() const {
 void HdRprIpcDelegate::CommitResources(HdChangeTracker* tracker) {
     // CommitResources() is called after prim sync has finished, but before any
     // tasks (such as draw tasks) have run.
+    m_session->BeginSync(this);
+
+    if (m_session->GetServer()->Commit()) {
+        m_renderParam->RestartRender();
+    }
+    m_renderParam->transformHierarchy.Commit();
+    if (m_renderParam->backgroundUploads.Commit()) {
+        m_renderParam->RestartRender();
+    }
+    m_renderParam->chunkAggregator.Commit();
+
+    m_session->EndSync(this);
 }
 
 TfToken HdRprIpcDelegate::GetMaterialNetworkSelector() const {
@@ -124,15 +207,15 @@ void HdRprIpcDelegate::DestroyRprim(HdRprim* rPrim) {
 HdSprim* HdRprIpcDelegate::CreateSprim(TfToken const& typeId,
                                     SdfPath const& sprimId) {
     if (typeId == HdPrimTypeTokens->camera) {
-        return new HdCamera(sprimId);
-    } /*else if (typeId == HdPrimTypeTokens->rectLight ||
+        return new HdRprCamera(sprimId);
+    } else if (typeId == HdPrimTypeTokens->material) {
+        return new HdRprMaterial(sprimId);
+    } else if (typeId == HdPrimTypeTokens->rectLight ||
         typeId == HdPrimTypeTokens->sphereLight ||
         typeId == HdPrimTypeTokens->cylinderLight ||
         typeId == HdPrimTypeTokens->diskLight) {
         return new HdRprLight(sprimId, typeId);
-    } else if (typeId == HdPrimTypeTokens->material) {
-        return new HdRprMaterial(sprimId);
-    }*/
+    }
 
     TF_CODING_ERROR("Unknown Sprim Type %s", typeId.GetText());
     return nullptr;
@@ -142,15 +225,15 @@ HdSprim* HdRprIpcDelegate::CreateFallbackSprim(TfToken const& typeId) {
     // For fallback sprims, create objects with an empty scene path.
     // They'll use default values and won't be updated by a scene delegate.
     if (typeId == HdPrimTypeTokens->camera) {
-        return new HdCamera(SdfPath::EmptyPath());
-    }/* else if (typeId == HdPrimTypeTokens->rectLight ||
+        return new HdRprCamera(SdfPath::EmptyPath());
+    } else if (typeId == HdPrimTypeTokens->material) {
+        return new HdRprMaterial(SdfPath::EmptyPath());
+    } else if (typeId == HdPrimTypeTokens->rectLight ||
         typeId == HdPrimTypeTokens->sphereLight ||
         typeId == HdPrimTypeTokens->cylinderLight ||
         typeId == HdPrimTypeTokens->diskLight) {
         return new HdRprLight(SdfPath::EmptyPath(), typeId);
-    } else if (typeId == HdPrimTypeTokens->material) {
-        return new HdRprMaterial(SdfPath::EmptyPath());
-    }*/
+    }
 
     TF_CODING_ERROR("Unknown Sprim Type %s", typeId.GetText());
     return nullptr;
@@ -181,16 +264,24 @@ void HdRprIpcDelegate::DestroyBprim(HdBprim* bPrim) {
 HdAovDescriptor HdRprIpcDelegate::GetDefaultAovDescriptor(TfToken const& name) const {
     if (name == HdAovTokens->color) {
         return HdAovDescriptor(HdFormatFloat32Vec4, false, VtValue(GfVec4f(0.0f)));
+    } else if (name == HdAovTokens->depth) {
+        return HdAovDescriptor(HdFormatFloat32, false, VtValue(1.0f));
+    } else if (name == HdAovTokens->primId ||
+               name == HdAovTokens->instanceId) {
+        return HdAovDescriptor(HdFormatInt32, false, VtValue(-1));
+    } else if (name == HdAovTokens->normal ||
+               name == HdRprIpcAovTokens->albedo) {
+        return HdAovDescriptor(HdFormatFloat32Vec3, false, VtValue(GfVec3f(0.0f)));
     }
     return HdAovDescriptor();
 }
 
 HdRenderSettingDescriptorList HdRprIpcDelegate::GetRenderSettingDescriptors() const {
-    return {};
+    return m_settingDescriptors;
 }
 
 VtDictionary HdRprIpcDelegate::GetRenderStats() const {
-    return {};
+    return m_renderParam->GetMemoryStats();
 }
 
 bool HdRprIpcDelegate::IsPauseSupported() const {
@@ -215,10 +306,13 @@ bool HdRprIpcDelegate::IsStopSupported() const {
 
 bool HdRprIpcDelegate::Stop() {
     m_renderThread.StopRender();
+    // In-flight part uploads are canceled, they are written again on restart
+    m_renderParam->backgroundUploads.CancelAll();
     return true;
 }
 
 bool HdRprIpcDelegate::Restart() {
+    m_renderParam->backgroundUploads.ResumeAll();
     m_renderParam->RestartRender();
     m_renderThread.StartRender();
     return true;
@@ -229,8 +323,55 @@ bool HdRprIpcDelegate::Restart() {
 bool HdRprIpcDelegate::ProcessCommand(
     std::string const& command,
     uint8_t* payload, size_t pyaloadSize) {
-    // no commands yet
+    // Session wide commands are handled by HdRprIpcSession
+    if (command == "tile") {
+        return ProcessTile(payload, pyaloadSize);
+    }
+
     return false;
 }
 
+bool HdRprIpcDelegate::ProcessTile(uint8_t const* payload, size_t payloadSize) {
+    // "<viewport path> <frame index> <aov> <x> <y> <width> <height>\n" header followed by pixels
+    auto headerEnd = std::find(payload, payload + payloadSize, '\n');
+    if (headerEnd == payload + payloadSize) {
+        return false;
+    }
+
+    auto header = TfStringTokenize(std::string(reinterpret_cast<const char*>(payload), headerEnd - payload));
+    if (header.size() != 7) {
+        TF_WARN("Malformed tile header");
+        return false;
+    }
+
+    // Tiles of other viewports are handled by their render delegates
+    if (header[0] != m_viewportPath.GetString()) {
+        return false;
+    }
+
+    errno = 0;
+    char* frameIndexEnd = nullptr;
+    uint64_t frameIndex = std::strtoull(header[1].c_str(), &frameIndexEnd, 10);
+    if (frameIndexEnd == header[1].c_str() || *frameIndexEnd != '\0' || errno == ERANGE) {
+        TF_WARN("Malformed tile frame index: %s", header[1].c_str());
+        return true;
+    }
+
+    // Bands start inside the frame and are never empty
+    GfVec4i rect;
+    for (int i = 0; i < 4; ++i) {
+        long minValue = i < 2 ? 0 : 1;
+        if (!ParseInt(header[3 + i], minValue, std::numeric_limits<int>::max(), &rect[i])) {
+            TF_WARN("Malformed tile rect: %s", header[3 + i].c_str());
+            return true;
+        }
+    }
+
+    auto pixels = headerEnd + 1;
+    if (!m_renderParam->BlitTile(frameIndex, TfToken(header[2]), rect, pixels, payload + payloadSize - pixels)) {
+        TF_WARN("Failed to composite tile of %s AOV", header[2].c_str());
+    }
+    return true;
+}
+
 PXR_NAMESPACE_CLOSE_SCOPE
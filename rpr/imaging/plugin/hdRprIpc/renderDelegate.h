@@ -18,10 +18,45 @@ limitations under the License.
 #include "renderParam.h"
 
 #include "pxr/imaging/hd/renderDelegate.h"
+#include "pxr/base/tf/staticTokens.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
-class RprIpcServer;
+#define HDRPRIPC_AOV_TOKENS \
+    (albedo)
+
+TF_DECLARE_PUBLIC_TOKENS(HdRprIpcAovTokens, HDRPRIPC_AOV_TOKENS);
+
+#define HDRPRIPC_RENDER_SETTINGS_TOKENS \
+    (frame) \
+    (motionBlurSamples) \
+    (geometryFormat) \
+    (dropSentGeometry) \
+    (aggregationMaxPoints) \
+    (aggregationChunkSize) \
+    (normalsSource) \
+    (transformHierarchy) \
+    (streamingPointsBudget) \
+    (proxyMinPoints) \
+    (uploadPartFaces) \
+    (renderServers) \
+    (renderTags)
+
+TF_DECLARE_PUBLIC_TOKENS(HdRprIpcRenderSettingsTokens, HDRPRIPC_RENDER_SETTINGS_TOKENS);
+
+/// Reads numeric render setting \p key. Applications set settings with whatever
+/// numeric type they have at hand, e.g. double frames, so such values are converted to \p T
+template <typename T>
+T HdRprIpcGetNumericRenderSetting(HdRenderDelegate const* renderDelegate, TfToken const& key, T const& defaultValue) {
+    auto value = renderDelegate->GetRenderSetting(key);
+    if (value.IsHolding<T>()) {
+        return value.UncheckedGet<T>();
+    } else if (value.CanCast<T>()) {
+        return VtValue::Cast<T>(value).UncheckedGet<T>();
+    }
+    return defaultValue;
+}
+
 class HdRprIpcLayer;
 
 class HdRprIpcDelegate final : public HdRenderDelegate, public RprIpcServer::Listener {
@@ -87,14 +122,21 @@ public:
     bool ProcessCommand(std::string const& command,
                         uint8_t* payload, size_t pyaloadSize) override;
 
+private:
+    bool ProcessTile(uint8_t const* payload, size_t payloadSize);
+
 private:
     static const TfTokenVector SUPPORTED_RPRIM_TYPES;
     static const TfTokenVector SUPPORTED_SPRIM_TYPES;
     static const TfTokenVector SUPPORTED_BPRIM_TYPES;
 
+    HdRenderSettingDescriptorList m_settingDescriptors;
+
     HdRprRenderThread m_renderThread;
 
-    std::unique_ptr<RprIpcServer> m_ipcServer;
+    // Shared with other render delegates, see HdRprIpcSession
+    std::shared_ptr<HdRprIpcSession> m_session;
+    SdfPath m_viewportPath;
     std::unique_ptr<HdRprRenderParam> m_renderParam;
 };
 
@@ -0,0 +1,295 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "renderParam.h"
+#include "renderBuffer.h"
+
+#include "pxr/imaging/hd/changeTracker.h"
+#include "pxr/imaging/hd/renderIndex.h"
+#include "pxr/imaging/hd/sceneDelegate.h"
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/sdf/types.h"
+
+#include <algorithm>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    ((aovs, "rpr:aovs"))
+    ((frame, "rpr:frame"))
+    ((frameIndex, "rpr:frameIndex"))
+    ((tiles, "rpr:tiles"))
+    (geometryMemory)
+    (geometryMemoryPerPrim)
+    (syncMemoryPerCategory)
+);
+
+namespace {
+
+const std::string kMallocTagPrefix("HdRprIpc:");
+const std::chrono::seconds kCategoryMemoryUsagePeriod(1);
+
+VtDictionary GetCategoryMemoryUsage() {
+    VtDictionary perCategoryMemory;
+    TfMallocTag::CallTree callTree;
+    if (TfMallocTag::GetCallTree(&callTree, false)) {
+        for (auto& callSite : callTree.callSites) {
+            if (TfStringStartsWith(callSite._name, kMallocTagPrefix)) {
+                perCategoryMemory[callSite._name.substr(kMallocTagPrefix.size())] = VtValue(size_t(std::max<int64_t>(callSite._nBytes, 0)));
+            }
+        }
+    }
+    return perCategoryMemory;
+}
+
+} // namespace anonymous
+
+HdRprRenderParam::~HdRprRenderParam() {
+    if (m_renderSettingsLayer) {
+        ipcServer->RemoveLayer(m_renderSettingsPath);
+    }
+}
+
+UsdPrim HdRprRenderParam::GetRenderSettingsPrim() {
+    if (!m_renderSettingsLayer) {
+        m_renderSettingsLayer = ipcServer->AddLayer(m_renderSettingsPath);
+        if (!m_renderSettingsLayer) {
+            return UsdPrim();
+        }
+    }
+
+    auto stage = m_renderSettingsLayer->GetStage();
+    if (auto prim = stage->GetPrimAtPath(m_renderSettingsPath)) {
+        return prim;
+    }
+    return stage->DefinePrim(m_renderSettingsPath);
+}
+
+void HdRprRenderParam::CommitRenderSettings() {
+    if (m_renderSettingsLayer) {
+        ipcServer->OnLayerEdit(m_renderSettingsPath, m_renderSettingsLayer);
+    }
+}
+
+bool HdRprRenderParam::SetActiveAovs(HdRenderPass const* renderPass, TfTokenVector const& aovNames) {
+    m_renderPassAovs[renderPass] = aovNames;
+    return UpdateActiveAovs();
+}
+
+bool HdRprRenderParam::RemoveActiveAovs(HdRenderPass const* renderPass) {
+    if (!m_renderPassAovs.erase(renderPass)) {
+        return false;
+    }
+    return UpdateActiveAovs();
+}
+
+bool HdRprRenderParam::UpdateActiveAovs() {
+    std::set<TfToken> aovUnion;
+    for (auto& entry : m_renderPassAovs) {
+        aovUnion.insert(entry.second.begin(), entry.second.end());
+    }
+
+    TfTokenVector activeAovs(aovUnion.begin(), aovUnion.end());
+    if (m_activeAovs == activeAovs) {
+        return false;
+    }
+    m_activeAovs = std::move(activeAovs);
+
+    auto prim = GetRenderSettingsPrim();
+    if (!prim) {
+        return true;
+    }
+
+    VtTokenArray aovs(m_activeAovs.begin(), m_activeAovs.end());
+    prim.CreateAttribute(_tokens->aovs, SdfValueTypeNames->TokenArray, true).Set(aovs);
+    CommitRenderSettings();
+
+    return true;
+}
+
+bool HdRprRenderParam::AcquirePrimaryRenderPass(HdRenderPass const* renderPass, bool hasAovBindings) {
+    if (m_primaryRenderPass != renderPass &&
+        m_primaryRenderPass && (m_primaryRenderPassHasAovBindings || !hasAovBindings)) {
+        return false;
+    }
+    m_primaryRenderPass = renderPass;
+    m_primaryRenderPassHasAovBindings = hasAovBindings;
+    return true;
+}
+
+void HdRprRenderParam::ReleasePrimaryRenderPass(HdRenderPass const* renderPass) {
+    if (m_primaryRenderPass == renderPass) {
+        m_primaryRenderPass = nullptr;
+        m_primaryRenderPassHasAovBindings = false;
+    }
+}
+
+bool HdRprRenderParam::SetFrame(double frame) {
+    if (m_frame == frame) {
+        return false;
+    }
+    m_frame = frame;
+    auto frameIndex = ++m_frameIndex;
+
+    auto prim = GetRenderSettingsPrim();
+    if (!prim) {
+        return true;
+    }
+
+    prim.CreateAttribute(_tokens->frame, SdfValueTypeNames->Double, true).Set(frame);
+    prim.CreateAttribute(_tokens->frameIndex, SdfValueTypeNames->UInt64, true).Set(uint64_t(frameIndex));
+    CommitRenderSettings();
+
+    return true;
+}
+
+bool HdRprRenderParam::SetRenderServers(int numRenderServers, GfVec2i const& resolution) {
+    if (numRenderServers == m_numRenderServers && resolution == m_tilesResolution) {
+        return false;
+    }
+    m_numRenderServers = numRenderServers;
+    m_tilesResolution = resolution;
+
+    if (numRenderServers <= 0) {
+        TF_WARN("Invalid number of render servers: %d, the frame is rendered by a single server", numRenderServers);
+        numRenderServers = 1;
+    }
+
+    VtVec4iArray tiles;
+    int numBands = std::max(std::min(numRenderServers, resolution[1]), 1);
+    if (numBands > 1) {
+        tiles.reserve(numBands);
+        for (int i = 0; i < numBands; ++i) {
+            int y0 = resolution[1] * i / numBands;
+            int y1 = resolution[1] * (i + 1) / numBands;
+            tiles.push_back(GfVec4i(0, y0, resolution[0], y1 - y0));
+        }
+    }
+
+    if (m_tiles == tiles) {
+        return false;
+    }
+    m_tiles = tiles;
+
+    auto prim = GetRenderSettingsPrim();
+    if (!prim) {
+        return true;
+    }
+
+    // No tiles means the whole frame is rendered by a single server
+    prim.CreateAttribute(_tokens->tiles, SdfValueTypeNames->Int4Array, true).Set(m_tiles);
+    CommitRenderSettings();
+
+    return true;
+}
+
+void HdRprRenderParam::SetAovBuffers(std::map<TfToken, HdRprRenderBuffer*> aovBuffers) {
+    std::lock_guard<std::mutex> lock(m_aovBuffersMutex);
+    m_aovBuffers = std::move(aovBuffers);
+}
+
+void HdRprRenderParam::RemoveAovBuffer(HdRprRenderBuffer* renderBuffer) {
+    std::lock_guard<std::mutex> lock(m_aovBuffersMutex);
+    for (auto it = m_aovBuffers.begin(); it != m_aovBuffers.end();) {
+        if (it->second == renderBuffer) {
+            it = m_aovBuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool HdRprRenderParam::BlitTile(uint64_t frameIndex, TfToken const& aovName, GfVec4i const& rect, uint8_t const* data, size_t dataSize) {
+    if (frameIndex != m_frameIndex.load()) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_aovBuffersMutex);
+
+    auto it = m_aovBuffers.find(aovName);
+    if (it == m_aovBuffers.end()) {
+        return false;
+    }
+
+    // The buffer validates the tile against its current size and format
+    return it->second->BlitTile(rect[0], rect[1], rect[2], rect[3], data, dataSize);
+}
+
+void HdRprRenderParam::SetPrimMemoryUsage(SdfPath const& id, size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_primMemoryUsageMutex);
+    if (bytes) {
+        m_primMemoryUsage[id] = bytes;
+    } else {
+        m_primMemoryUsage.erase(id);
+    }
+}
+
+VtDictionary HdRprRenderParam::GetMemoryStats() const {
+    std::lock_guard<std::mutex> lock(m_primMemoryUsageMutex);
+
+    size_t totalMemory = 0;
+    VtDictionary perPrimMemory;
+    for (auto& entry : m_primMemoryUsage) {
+        totalMemory += entry.second;
+        perPrimMemory[entry.first.GetString()] = VtValue(entry.second);
+    }
+
+    VtDictionary stats;
+    stats[_tokens->geometryMemory.GetString()] = VtValue(totalMemory);
+    stats[_tokens->geometryMemoryPerPrim.GetString()] = VtValue(perPrimMemory);
+
+    if (TfMallocTag::IsInitialized()) {
+        auto now = std::chrono::steady_clock::now();
+        if (m_categoryMemoryUsage.empty() || now - m_categoryMemoryUsageTime >= kCategoryMemoryUsagePeriod) {
+            m_categoryMemoryUsage = GetCategoryMemoryUsage();
+            m_categoryMemoryUsageTime = now;
+        }
+        stats[_tokens->syncMemoryPerCategory.GetString()] = VtValue(m_categoryMemoryUsage);
+    }
+    return stats;
+}
+
+void HdRprRenderParam::SubscribeForMaterialUpdates(SdfPath const& materialId, SdfPath const& rprimId) {
+    std::lock_guard<std::mutex> lock(m_materialSubscriptionsMutex);
+    m_materialSubscriptions[materialId].insert(rprimId);
+}
+
+void HdRprRenderParam::UnsubscribeFromMaterialUpdates(SdfPath const& materialId, SdfPath const& rprimId) {
+    std::lock_guard<std::mutex> lock(m_materialSubscriptionsMutex);
+
+    auto it = m_materialSubscriptions.find(materialId);
+    if (it != m_materialSubscriptions.end()) {
+        it->second.erase(rprimId);
+        if (it->second.empty()) {
+            m_materialSubscriptions.erase(it);
+        }
+    }
+}
+
+void HdRprRenderParam::MaterialDidChange(HdSceneDelegate* sceneDelegate, SdfPath const& materialId) {
+    std::lock_guard<std::mutex> lock(m_materialSubscriptionsMutex);
+
+    auto it = m_materialSubscriptions.find(materialId);
+    if (it == m_materialSubscriptions.end()) {
+        return;
+    }
+
+    auto& changeTracker = sceneDelegate->GetRenderIndex().GetChangeTracker();
+    for (auto& rprimId : it->second) {
+        changeTracker.MarkRprimDirty(rprimId, HdChangeTracker::DirtyMaterialId);
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -15,32 +15,166 @@ limitations under the License.
 #define HDRPR_RENDER_PARAM_H
 
 #include "pxr/imaging/hd/renderDelegate.h"
-#include "server.h"
+#include "session.h"
+#include "cameraChannel.h"
+#include "renderTagFilter.h"
+#include "publishQueue.h"
+#include "backgroundUploads.h"
+#include "ipcServer.h"
 #include "pxr/usd/sdf/path.h"
+#include "pxr/usd/usd/prim.h"
+#include "pxr/base/gf/vec2i.h"
+#include "pxr/base/gf/vec4i.h"
+#include "pxr/base/vt/types.h"
+#include "pxr/base/tf/mallocTag.h"
+#include "pxr/base/tf/preprocessorUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <map>
+#include <set>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
-class RprIpcServer;
+/// Attributes allocations of the enclosing scope to \p category, see HdRprRenderParam::GetMemoryStats.
+/// Sync allocations are not pooled per sync: nearly all of them are VtArrays and Sdf specs that stay
+/// in the layers after the batch is sent, so they are reused in place (e.g. normals) instead
+#define HDRPRIPC_MALLOC_TAG(category) TfAutoMallocTag TF_PP_CAT(mallocTag, __LINE__)("HdRprIpc:" category)
+
+class HdRprIpcServer;
 class HdRprIpcLayer;
 class HdRprRenderThread;
+class HdRprRenderBuffer;
 
 class HdRprRenderParam final : public HdRenderParam {
 public:
-    HdRprRenderParam(RprIpcServer* ipcServer, HdRprRenderThread* renderThread)
-        : ipcServer(ipcServer)
-        , renderThread(renderThread) {
+    /// Layers that are not shared with other render delegates of \p session are placed under \p viewportPath
+    HdRprRenderParam(HdRprIpcSession* session, SdfPath const& viewportPath, HdRprRenderThread* renderThread, HdRenderDelegate* renderDelegate)
+        : ipcServer(session->GetServer())
+        , session(session)
+        , renderThread(renderThread)
+        , renderDelegate(renderDelegate)
+        , payloadStore(session->payloadStore)
+        , chunkAggregator(session->chunkAggregator)
+        , materialRegistry(session->materialRegistry)
+        , lightShapes(session->lightShapes)
+        , transformHierarchy(session->transformHierarchy)
+        , cameraChannel(ipcServer, viewportPath)
+        , backgroundUploads(&payloadStore)
+        , m_renderSettingsPath(viewportPath.AppendChild(TfToken("RenderSettings"))) {
 
     }
-    ~HdRprRenderParam() override = default;
+    ~HdRprRenderParam() override;
 
-    RprIpcServer* ipcServer;
+    HdRprIpcServer* ipcServer;
+    HdRprIpcSession* session;
     HdRprRenderThread* renderThread;
+    HdRenderDelegate* renderDelegate;
+    // Shared by all render delegates of the session
+    HdRprIpcPayloadStore& payloadStore;
+    HdRprIpcChunkAggregator& chunkAggregator;
+    HdRprIpcMaterialRegistry& materialRegistry;
+    HdRprIpcLightShapes& lightShapes;
+    HdRprIpcTransformHierarchy& transformHierarchy;
+    HdRprIpcCameraChannel cameraChannel;
+    HdRprIpcRenderTagFilter renderTagFilter;
+    HdRprIpcPublishQueue publishQueue;
+    HdRprIpcBackgroundUploads backgroundUploads;
+
+    /// Called by every prim sync, see HdRprIpcSession::BeginSync
+    void BeginSync() { session->BeginSync(renderDelegate); }
 
     void RestartRender() { m_restartRender.store(true); }
     bool IsRenderShouldBeRestarted() { return m_restartRender.exchange(false); }
 
+    /// Sets AOVs that are bound in \p renderPass.
+    /// The viewer produces and transfers only the union of AOVs bound across all render passes.
+    /// Returns true if the union has changed.
+    bool SetActiveAovs(HdRenderPass const* renderPass, TfTokenVector const& aovNames);
+    /// Removes AOVs of a destroyed render pass from the union, see SetActiveAovs
+    bool RemoveActiveAovs(HdRenderPass const* renderPass);
+    TfTokenVector const& GetActiveAovs() const { return m_activeAovs; }
+
+    /// Viewer renders a single view per render delegate, so the camera is sent by one render pass only.
+    /// The first pass that executes becomes primary, a pass with bound render buffers takes over
+    /// a primary pass without them. Returns true if \p renderPass is primary.
+    bool AcquirePrimaryRenderPass(HdRenderPass const* renderPass, bool hasAovBindings);
+    /// Called by a destroyed render pass, the next executed pass becomes primary
+    void ReleasePrimaryRenderPass(HdRenderPass const* renderPass);
+
+    /// Splits the frame of \p resolution between \p numRenderServers render servers.
+    /// Every server renders one horizontal band, tile rects are indexed by the server index.
+    /// Non-positive \p numRenderServers is rejected with a warning and a single server is used.
+    /// Set by the primary render pass only, see AcquirePrimaryRenderPass.
+    /// Returns true if the partition has changed
+    bool SetRenderServers(int numRenderServers, GfVec2i const& resolution);
+
+    /// Render buffers of the primary render pass that tiles sent by render servers are composited into
+    void SetAovBuffers(std::map<TfToken, HdRprRenderBuffer*> aovBuffers);
+    void RemoveAovBuffer(HdRprRenderBuffer* renderBuffer);
+
+    /// Copies a tile of \p aovName AOV into its render buffer,
+    /// \p data holds tightly packed pixels in the format of the buffer.
+    /// \p frameIndex is the index the viewer received with the frame it rendered the tile for.
+    /// Tiles of other than the current frame are late results of a pipelined render and are dropped.
+    /// Returns false if the AOV is not bound or the data does not match the tile size
+    bool BlitTile(uint64_t frameIndex, TfToken const& aovName, GfVec4i const& rect, uint8_t const* data, size_t dataSize);
+
+    /// Sets the frame the viewer should render.
+    /// Every change of the frame is sent with a new frame index, the viewer stamps tiles with it.
+    /// Returns true if the frame has changed.
+    bool SetFrame(double frame);
+
+    /// Records amount of client-side memory that is occupied by prim data.
+    /// Zero removes the prim from the memory report.
+    void SetPrimMemoryUsage(SdfPath const& id, size_t bytes);
+
+    /// Returns total and per prim memory usage.
+    /// When malloc tagging is initialized, bytes currently held by allocations
+    /// of each HDRPRIPC_MALLOC_TAG category are reported as well.
+    /// Walking the malloc tag call tree is expensive, so the categories are refreshed at most once a second
+    VtDictionary GetMemoryStats() const;
+
+    /// Rprims bind materials by the path of the deduplicated material,
+    /// MaterialDidChange marks subscribed rprims dirty when this path changes
+    void SubscribeForMaterialUpdates(SdfPath const& materialId, SdfPath const& rprimId);
+    void UnsubscribeFromMaterialUpdates(SdfPath const& materialId, SdfPath const& rprimId);
+    void MaterialDidChange(HdSceneDelegate* sceneDelegate, SdfPath const& materialId);
+
+private:
+    bool UpdateActiveAovs();
+    UsdPrim GetRenderSettingsPrim();
+    void CommitRenderSettings();
+
 private:
     std::atomic<bool> m_restartRender;
+
+    SdfPath m_renderSettingsPath;
+    RprIpcServer::Layer* m_renderSettingsLayer = nullptr;
+    TfTokenVector m_activeAovs;
+    std::map<HdRenderPass const*, TfTokenVector> m_renderPassAovs;
+    HdRenderPass const* m_primaryRenderPass = nullptr;
+    bool m_primaryRenderPassHasAovBindings = false;
+    double m_frame = std::numeric_limits<double>::quiet_NaN();
+    // Read by BlitTile on the server thread
+    std::atomic<uint64_t> m_frameIndex{0};
+    VtVec4iArray m_tiles;
+    int m_numRenderServers = 1;
+    GfVec2i m_tilesResolution = GfVec2i(0);
+
+    std::mutex m_aovBuffersMutex;
+    std::map<TfToken, HdRprRenderBuffer*> m_aovBuffers;
+
+    mutable std::mutex m_primMemoryUsageMutex;
+    std::map<SdfPath, size_t> m_primMemoryUsage;
+    mutable VtDictionary m_categoryMemoryUsage;
+    mutable std::chrono::steady_clock::time_point m_categoryMemoryUsageTime;
+
+    std::mutex m_materialSubscriptionsMutex;
+    std::map<SdfPath, std::set<SdfPath>> m_materialSubscriptions;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
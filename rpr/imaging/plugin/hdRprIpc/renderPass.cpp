@@ -15,12 +15,16 @@ limitations under the License.
 #include "renderDelegate.h"
 #include "renderBuffer.h"
 #include "renderParam.h"
+#include "camera.h"
 
 #include "pxr/imaging/hd/renderPassState.h"
 #include "pxr/imaging/hd/renderIndex.h"
 
 #include <GL/glew.h>
 
+#include <limits>
+#include <map>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 HdRprRenderPass::HdRprRenderPass(HdRenderIndex* index,
@@ -31,7 +35,82 @@ HdRprRenderPass::HdRprRenderPass(HdRenderIndex* index,
 
 }
 
+HdRprRenderPass::~HdRprRenderPass() {
+    m_renderParam->RemoveActiveAovs(this);
+    m_renderParam->ReleasePrimaryRenderPass(this);
+    if (m_renderParam->renderTagFilter.RemoveRenderPass(this, GetRenderIndex()->GetChangeTracker())) {
+        m_renderParam->RestartRender();
+    }
+}
+
 void HdRprRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, TfTokenVector const& renderTags) {
+    // Request only those AOVs that are actually read by the application.
+    // Passes bound to different AOVs, e.g. picking and color, share the union so they do not restart each other
+    TfTokenVector aovNames;
+    for (auto& aovBinding : renderPassState->GetAovBindings()) {
+        if (aovBinding.renderBuffer) {
+            aovNames.push_back(aovBinding.aovName);
+        }
+    }
+    if (aovNames.empty()) {
+        aovNames.push_back(HdAovTokens->color);
+    }
+    if (m_renderParam->SetActiveAovs(this, aovNames)) {
+        m_renderParam->RestartRender();
+    }
+
+    // Tiles rendered by render servers are composited into the bound render buffers
+    std::map<TfToken, HdRprRenderBuffer*> aovBuffers;
+    GfVec2i resolution(0);
+    for (auto& aovBinding : renderPassState->GetAovBindings()) {
+        if (aovBinding.renderBuffer) {
+            auto rprRenderBuffer = static_cast<HdRprRenderBuffer*>(aovBinding.renderBuffer);
+            aovBuffers.emplace(aovBinding.aovName, rprRenderBuffer);
+            resolution = GfVec2i(rprRenderBuffer->GetWidth(), rprRenderBuffer->GetHeight());
+        }
+    }
+    // Frame is partitioned between render servers by the resolution of the primary pass
+    // and its buffers receive the tiles, other passes would otherwise repartition it on every frame
+    bool isPrimary = m_renderParam->AcquirePrimaryRenderPass(this, !aovBuffers.empty());
+    if (isPrimary) {
+        m_renderParam->SetAovBuffers(std::move(aovBuffers));
+
+        int numRenderServers = HdRprIpcGetNumericRenderSetting(m_renderParam->renderDelegate, HdRprIpcRenderSettingsTokens->renderServers, 1);
+        if (m_renderParam->SetRenderServers(numRenderServers, resolution)) {
+            m_renderParam->RestartRender();
+        }
+    }
+
+    if (m_renderParam->renderTagFilter.SetActiveRenderTags(this, renderTags, GetRenderIndex()->GetChangeTracker())) {
+        m_renderParam->RestartRender();
+    }
+
+    auto frame = HdRprIpcGetNumericRenderSetting(m_renderParam->renderDelegate, HdRprIpcRenderSettingsTokens->frame, 0.0f);
+    if (m_renderParam->SetFrame(frame)) {
+        m_renderParam->RestartRender();
+    }
+
+    // Camera is sent once per execution of the primary pass, intermediate camera edits are coalesced.
+    // Other passes, e.g. picking or shadow passes, would otherwise replace it with their own on every frame
+    HdRprIpcCameraState cameraState;
+    cameraState.viewMatrix = renderPassState->GetWorldToViewMatrix();
+    cameraState.projectionMatrix = renderPassState->GetProjectionMatrix();
+    if (auto camera = static_cast<HdRprCamera const*>(renderPassState->GetCamera())) {
+        cameraState.focalLength = camera->GetFocalLength();
+        cameraState.fStop = camera->GetFStop();
+        cameraState.focusDistance = camera->GetFocusDistance();
+    }
+    if (isPrimary && m_renderParam->cameraChannel.Send(cameraState)) {
+        m_renderParam->RestartRender();
+    }
+
+    // Newly created meshes are streamed by their priority for the camera of this pass
+    int streamingPointsBudget = HdRprIpcGetNumericRenderSetting(m_renderParam->renderDelegate, HdRprIpcRenderSettingsTokens->streamingPointsBudget, 0);
+    size_t pointsBudget = streamingPointsBudget > 0 ? size_t(streamingPointsBudget) : std::numeric_limits<size_t>::max();
+    if (m_renderParam->publishQueue.Publish(cameraState.viewMatrix * cameraState.projectionMatrix, pointsBudget)) {
+        m_renderParam->RestartRender();
+    }
+
     if (m_renderParam->IsRenderShouldBeRestarted()) {
         for (auto& aovBinding : renderPassState->GetAovBindings()) {
             if (aovBinding.renderBuffer) {
@@ -26,7 +26,7 @@ public:
                     HdRprimCollection const& collection,
                     HdRprRenderParam* renderParam);
 
-    ~HdRprRenderPass() override = default;
+    ~HdRprRenderPass() override;
 
     bool IsConverged() const override;
 
@@ -0,0 +1,97 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "renderTagFilter.h"
+
+#include <algorithm>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+bool HdRprIpcRenderTagFilter::IsActive(TfToken const& renderTag) const {
+    return m_activeRenderTags.empty() ||
+        std::binary_search(m_activeRenderTags.begin(), m_activeRenderTags.end(), renderTag);
+}
+
+void HdRprIpcRenderTagFilter::SetPublished(SdfPath const& id, TfToken const& renderTag, Prim* prim) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_publishedPrims[id] = {renderTag, prim};
+}
+
+void HdRprIpcRenderTagFilter::RemovePrim(SdfPath const& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_publishedPrims.erase(id);
+}
+
+void HdRprIpcRenderTagFilter::SetDefaultRenderTags(TfTokenVector const& renderTags) {
+    m_defaultRenderTags = renderTags;
+    if (m_renderPassTags.empty()) {
+        m_activeRenderTags = renderTags;
+        std::sort(m_activeRenderTags.begin(), m_activeRenderTags.end());
+        m_activeRenderTags.erase(std::unique(m_activeRenderTags.begin(), m_activeRenderTags.end()), m_activeRenderTags.end());
+    }
+}
+
+bool HdRprIpcRenderTagFilter::SetActiveRenderTags(HdRenderPass const* renderPass, TfTokenVector const& renderTags, HdChangeTracker& changeTracker) {
+    auto it = m_renderPassTags.find(renderPass);
+    if (it != m_renderPassTags.end() && it->second == renderTags) {
+        return false;
+    }
+    m_renderPassTags[renderPass] = renderTags;
+    return UpdateActiveRenderTags(changeTracker);
+}
+
+bool HdRprIpcRenderTagFilter::RemoveRenderPass(HdRenderPass const* renderPass, HdChangeTracker& changeTracker) {
+    if (!m_renderPassTags.erase(renderPass)) {
+        return false;
+    }
+    return UpdateActiveRenderTags(changeTracker);
+}
+
+bool HdRprIpcRenderTagFilter::UpdateActiveRenderTags(HdChangeTracker& changeTracker) {
+    TfTokenVector activeRenderTags;
+    if (m_renderPassTags.empty()) {
+        activeRenderTags = m_defaultRenderTags;
+    } else {
+        for (auto& entry : m_renderPassTags) {
+            // A pass without tags draws everything
+            if (entry.second.empty()) {
+                activeRenderTags.clear();
+                break;
+            }
+            activeRenderTags.insert(activeRenderTags.end(), entry.second.begin(), entry.second.end());
+        }
+    }
+    std::sort(activeRenderTags.begin(), activeRenderTags.end());
+    activeRenderTags.erase(std::unique(activeRenderTags.begin(), activeRenderTags.end()), activeRenderTags.end());
+    if (m_activeRenderTags == activeRenderTags) {
+        return false;
+    }
+    m_activeRenderTags = std::move(activeRenderTags);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_publishedPrims.begin(); it != m_publishedPrims.end();) {
+        if (IsActive(it->second.first)) {
+            ++it;
+            continue;
+        }
+
+        it->second.second->Unpublish();
+        changeTracker.MarkRprimDirty(it->first, HdChangeTracker::AllDirty);
+        it = m_publishedPrims.erase(it);
+    }
+
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,84 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_RENDER_TAG_FILTER_H
+#define HDRPR_RENDER_TAG_FILTER_H
+
+#include "pxr/imaging/hd/changeTracker.h"
+#include "pxr/imaging/hd/renderPass.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <mutex>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Keeps prims of render tags that are not drawn by any render pass off the wire.
+/// Prims of inactive tags are not populated at all, prims that were sent and
+/// whose tag gets deactivated are unpublished and marked dirty so that they are
+/// populated again once their tag is activated.
+///
+/// Active tags are the union of tags of all render passes, so that passes drawing
+/// different tags, e.g. beauty and guide passes, do not deactivate each other's prims.
+/// Before any pass has executed the default tags are active.
+class HdRprIpcRenderTagFilter {
+public:
+    class Prim {
+    public:
+        virtual ~Prim() = default;
+
+        /// Removes everything the prim has sent to the viewer
+        virtual void Unpublish() = 0;
+    };
+
+    HdRprIpcRenderTagFilter() = default;
+    ~HdRprIpcRenderTagFilter() = default;
+
+    HdRprIpcRenderTagFilter(const HdRprIpcRenderTagFilter&) = delete;
+    HdRprIpcRenderTagFilter& operator =(const HdRprIpcRenderTagFilter&) = delete;
+
+    /// Active render tags change only between syncs so this is safe to call from prim sync
+    bool IsActive(TfToken const& renderTag) const;
+
+    /// Records that \p prim with \p renderTag has been sent to the viewer
+    void SetPublished(SdfPath const& id, TfToken const& renderTag, Prim* prim);
+    void RemovePrim(SdfPath const& id);
+
+    /// Sets tags that are active until the first render pass sets its tags.
+    /// Must be called before the first sync
+    void SetDefaultRenderTags(TfTokenVector const& renderTags);
+
+    /// Sets render tags of \p renderPass, empty \p renderTags activates all tags.
+    /// Returns true if the set of active tags has changed
+    bool SetActiveRenderTags(HdRenderPass const* renderPass, TfTokenVector const& renderTags, HdChangeTracker& changeTracker);
+    /// Removes tags of a destroyed render pass from the union, see SetActiveRenderTags
+    bool RemoveRenderPass(HdRenderPass const* renderPass, HdChangeTracker& changeTracker);
+
+private:
+    bool UpdateActiveRenderTags(HdChangeTracker& changeTracker);
+
+private:
+    TfTokenVector m_defaultRenderTags;
+    std::map<HdRenderPass const*, TfTokenVector> m_renderPassTags;
+
+    // Sorted, empty if all tags are active
+    TfTokenVector m_activeRenderTags;
+
+    std::mutex m_mutex;
+    std::map<SdfPath, std::pair<TfToken, Prim*>> m_publishedPrims;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_RENDER_TAG_FILTER_H
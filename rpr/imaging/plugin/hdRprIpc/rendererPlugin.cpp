@@ -13,6 +13,7 @@ limitations under the License.
 
 #include "rendererPlugin.h"
 #include "renderDelegate.h"
+#include "session.h"
 
 #include "pxr/imaging/hd/rendererPluginRegistry.h"
 
@@ -22,6 +23,11 @@ TF_REGISTRY_FUNCTION(TfType) {
     HdRendererPluginRegistry::Define<HdRprIpcPlugin>();
 }
 
+HdRprIpcPlugin::HdRprIpcPlugin() {
+    // The plugin is instantiated ahead of its first render delegate
+    HdRprIpcSession::Prewarm();
+}
+
 HdRenderDelegate* HdRprIpcPlugin::CreateRenderDelegate() {
     return new HdRprIpcDelegate(HdRenderSettingsMap());
 }
@@ -20,7 +20,7 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 class HdRprIpcPlugin final : public HdRendererPlugin {
 public:
-    HdRprIpcPlugin() = default;
+    HdRprIpcPlugin();
     ~HdRprIpcPlugin() override = default;
 
     HdRprIpcPlugin(const HdRprIpcPlugin&) = delete;
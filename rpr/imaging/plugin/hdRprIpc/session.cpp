@@ -0,0 +1,138 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "session.h"
+
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/envSetting.h"
+#include "pxr/base/tf/stringUtils.h"
+
+#include <cstdlib>
+#include <future>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(HDRPRIPC_KEEP_SESSION, false,
+    "Start the viewer session as soon as the plugin is loaded and keep it alive between render delegates.");
+
+namespace {
+
+const SdfPath kViewportsPath("/RprIpc/Viewports");
+
+std::mutex g_sessionMutex;
+std::weak_ptr<HdRprIpcSession> g_session;
+
+// Holds the prewarmed session until the process exits or the plugin is unloaded
+std::shared_future<std::shared_ptr<HdRprIpcSession>> g_warmSession;
+
+// Destroys the prewarmed session while the plugin and USD are still alive rather than during
+// static destruction. Delegates that are still alive keep the session, the prewarm is waited for
+void ReleaseWarmSession() {
+    std::shared_future<std::shared_ptr<HdRprIpcSession>> warmSession;
+    {
+        std::lock_guard<std::mutex> lock(g_sessionMutex);
+        warmSession = std::move(g_warmSession);
+    }
+}
+
+} // namespace anonymous
+
+void HdRprIpcSession::Prewarm() {
+    if (!TfGetEnvSetting(HDRPRIPC_KEEP_SESSION)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(g_sessionMutex);
+    if (g_warmSession.valid()) {
+        return;
+    }
+
+    // The server binds to the viewer endpoint, so there is a single warm session rather than a pool
+    g_warmSession = std::async(std::launch::async, []() {
+        return std::shared_ptr<HdRprIpcSession>(new HdRprIpcSession);
+    }).share();
+
+    // Handlers registered by a shared library also run when it is unloaded
+    std::atexit(ReleaseWarmSession);
+}
+
+std::shared_ptr<HdRprIpcSession> HdRprIpcSession::Acquire() {
+    std::lock_guard<std::mutex> lock(g_sessionMutex);
+
+    auto session = g_session.lock();
+    if (!session) {
+        // Waits for the prewarm if it is still in progress
+        session = g_warmSession.valid() ? g_warmSession.get() : std::shared_ptr<HdRprIpcSession>(new HdRprIpcSession);
+        g_session = session;
+    }
+    return session;
+}
+
+HdRprIpcSession::HdRprIpcSession()
+    : m_server(std::make_unique<HdRprIpcServer>(this))
+    , materialRegistry(m_server.get())
+    , lightShapes(m_server.get())
+    , chunkAggregator(m_server.get())
+    , transformHierarchy(m_server.get()) {
+
+}
+
+SdfPath HdRprIpcSession::AddViewport(RprIpcServer::Listener* listener) {
+    std::lock_guard<std::mutex> lock(m_viewportsMutex);
+
+    auto viewportPath = kViewportsPath.AppendChild(TfToken(TfStringPrintf("viewport%zu", m_viewportCounter++)));
+    m_viewports.emplace(viewportPath, listener);
+    return viewportPath;
+}
+
+void HdRprIpcSession::RemoveViewport(SdfPath const& viewportPath) {
+    std::lock_guard<std::mutex> lock(m_viewportsMutex);
+    m_viewports.erase(viewportPath);
+}
+
+void HdRprIpcSession::BeginSync(HdRenderDelegate const* renderDelegate) {
+    // Prims of a render delegate are synced in parallel, the common case does not write
+    if (m_syncingDelegate.load() == renderDelegate) {
+        return;
+    }
+
+    HdRenderDelegate const* syncingDelegate = nullptr;
+    if (!m_syncingDelegate.compare_exchange_strong(syncingDelegate, renderDelegate) &&
+        syncingDelegate != renderDelegate) {
+        TF_CODING_ERROR("Render delegates that share a viewer session are synced concurrently");
+    }
+}
+
+void HdRprIpcSession::EndSync(HdRenderDelegate const* renderDelegate) {
+    m_syncingDelegate.compare_exchange_strong(renderDelegate, nullptr);
+}
+
+bool HdRprIpcSession::ProcessCommand(
+    std::string const& command,
+    uint8_t* payload, size_t payloadSize) {
+    if (command == "resync") {
+        // Sent by a restarted viewer, layers are resent on the next CommitResources of any delegate
+        return m_server->SetViewerVersions(payload, payloadSize);
+    }
+
+    std::lock_guard<std::mutex> lock(m_viewportsMutex);
+    for (auto& entry : m_viewports) {
+        if (entry.second->ProcessCommand(command, payload, payloadSize)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
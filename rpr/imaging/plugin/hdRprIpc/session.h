@@ -0,0 +1,104 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_SESSION_H
+#define HDRPR_SESSION_H
+
+#include "ipcServer.h"
+#include "payloadStore.h"
+#include "materialRegistry.h"
+#include "lightShapes.h"
+#include "chunkAggregator.h"
+#include "transformHierarchy.h"
+
+#include "pxr/imaging/hd/renderDelegate.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Process-wide connection to the viewer shared by all render delegates.
+/// Render delegates of several viewports on the same stage author prims into the same
+/// reference counted layers, so the viewer holds a single scene. Chunk and transform
+/// group layers aggregate those prims and are shared the same way, per viewport data
+/// (camera, render settings) is placed under the viewport path of every delegate.
+///
+/// The server outlives every render delegate and every helper of the session, which
+/// remove their layers on destruction. Helpers are declared after the server so that
+/// they are destroyed before it.
+///
+/// Hosts sync viewports one after another, prims of different delegates that share
+/// a layer are never synced concurrently. Shared layers and helpers rely on it instead
+/// of locking every edit, BeginSync verifies it.
+class HdRprIpcSession : public RprIpcServer::Listener {
+public:
+    /// Returns the current session or creates a new one, the session lives while any delegate holds it
+    static std::shared_ptr<HdRprIpcSession> Acquire();
+
+    /// When HDRPRIPC_KEEP_SESSION is enabled, starts creating the session in background.
+    /// The session is then kept alive until the process exits or the plugin is unloaded, so render
+    /// delegates created later, e.g. after switching renderers back and forth, find the connection
+    /// and the viewer already initialized
+    static void Prewarm();
+
+    ~HdRprIpcSession() override = default;
+
+    HdRprIpcSession(const HdRprIpcSession&) = delete;
+    HdRprIpcSession& operator =(const HdRprIpcSession&) = delete;
+
+    HdRprIpcServer* GetServer() { return m_server.get(); }
+
+    /// Registers a render delegate, commands that the session does not handle are forwarded to \p listener.
+    /// Returns path under which the delegate places its per viewport layers
+    SdfPath AddViewport(RprIpcServer::Listener* listener);
+    void RemoveViewport(SdfPath const& viewportPath);
+
+    bool ProcessCommand(std::string const& command,
+                        uint8_t* payload, size_t payloadSize) override;
+
+    /// Called by every prim sync and at the beginning of CommitResources of \p renderDelegate,
+    /// raises a coding error if another render delegate of the session is between its own
+    /// BeginSync and EndSync calls
+    void BeginSync(HdRenderDelegate const* renderDelegate);
+    /// Called at the end of CommitResources of \p renderDelegate
+    void EndSync(HdRenderDelegate const* renderDelegate);
+
+private:
+    HdRprIpcSession();
+
+private:
+    std::unique_ptr<HdRprIpcServer> m_server;
+
+public:
+    HdRprIpcPayloadStore payloadStore;
+    HdRprIpcMaterialRegistry materialRegistry;
+    HdRprIpcLightShapes lightShapes;
+    HdRprIpcChunkAggregator chunkAggregator;
+    HdRprIpcTransformHierarchy transformHierarchy;
+
+private:
+    std::mutex m_viewportsMutex;
+    std::map<SdfPath, RprIpcServer::Listener*> m_viewports;
+    size_t m_viewportCounter = 0;
+
+    std::atomic<HdRenderDelegate const*> m_syncingDelegate{nullptr};
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_SESSION_H
@@ -0,0 +1,216 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "transformHierarchy.h"
+#include "layerUtils.h"
+
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/usd/usd/stage.h"
+
+#include <algorithm>
+#include <cmath>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    (Xform)
+);
+
+namespace {
+
+constexpr double kTransformTolerance = 1e-6;
+
+} // namespace anonymous
+
+HdRprIpcTransformHierarchy::HdRprIpcTransformHierarchy(HdRprIpcServer* ipcServer)
+    : m_ipcServer(ipcServer)
+    , m_groupsPath("/RprIpc/TransformGroups") {
+
+}
+
+HdRprIpcTransformHierarchy::~HdRprIpcTransformHierarchy() {
+    for (auto& entry : m_groups) {
+        if (entry.second.layer) {
+            m_ipcServer->RemoveLayer(entry.second.layerPath);
+        }
+    }
+}
+
+void HdRprIpcTransformHierarchy::SetWorldTransform(SdfPath const& id, GfMatrix4d const& transform, Child* child) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& group = m_groups[id.GetParentPath()];
+    auto& state = group.children[id];
+    if (std::find(state.children.begin(), state.children.end(), child) == state.children.end()) {
+        state.children.push_back(child);
+    }
+    if (!state.isDirty) {
+        state.isDirty = true;
+        group.numDirtyChildren++;
+    }
+    state.worldTransform = transform;
+}
+
+void HdRprIpcTransformHierarchy::RemoveChild(SdfPath const& id, Child* child) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto groupIt = m_groups.find(id.GetParentPath());
+    if (groupIt == m_groups.end()) {
+        return;
+    }
+
+    auto& group = groupIt->second;
+    auto childIt = group.children.find(id);
+    if (childIt == group.children.end()) {
+        return;
+    }
+
+    auto& children = childIt->second.children;
+    children.erase(std::remove(children.begin(), children.end(), child), children.end());
+    if (!children.empty()) {
+        return;
+    }
+
+    if (childIt->second.isDirty) {
+        group.numDirtyChildren--;
+    }
+    group.children.erase(childIt);
+
+    if (group.children.empty()) {
+        if (group.layer) {
+            m_ipcServer->RemoveLayer(group.layerPath);
+        }
+        m_groups.erase(groupIt);
+    }
+}
+
+bool HdRprIpcTransformHierarchy::HasChild(SdfPath const& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto groupIt = m_groups.find(id.GetParentPath());
+    return groupIt != m_groups.end() && groupIt->second.children.count(id);
+}
+
+bool HdRprIpcTransformHierarchy::FindGroupTransform(Group const& group, GfMatrix4d* transform) {
+    // Group transform pays off only when it explains the edit of most children
+    if (group.children.size() < 2 || group.numDirtyChildren * 2 <= group.children.size()) {
+        return false;
+    }
+
+    for (auto& entry : group.children) {
+        auto& state = entry.second;
+        if (!state.isDirty || !state.isSent) {
+            continue;
+        }
+
+        // worldTransform = localTransform * groupTransform
+        double det;
+        auto localInverse = state.localTransform.GetInverse(&det);
+        if (std::abs(det) < kTransformTolerance) {
+            continue;
+        }
+        auto candidate = localInverse * state.worldTransform;
+        if (std::abs(candidate.GetDeterminant()) < kTransformTolerance) {
+            return false;
+        }
+
+        size_t numExplained = 0;
+        for (auto& childEntry : group.children) {
+            auto& childState = childEntry.second;
+            if (childState.isDirty && childState.isSent &&
+                GfIsClose(childState.localTransform * candidate, childState.worldTransform, kTransformTolerance)) {
+                numExplained++;
+            }
+        }
+
+        if (numExplained * 2 > group.children.size()) {
+            *transform = candidate;
+            return true;
+        }
+
+        // Children move independently, there is no point to try other candidates
+        return false;
+    }
+
+    return false;
+}
+
+bool HdRprIpcTransformHierarchy::SendGroupTransform(SdfPath const& groupPath, Group* group) {
+    if (!group->layer) {
+        group->layerPath = m_groupsPath.AppendChild(TfToken(TfStringPrintf("group%zu", m_groupCounter++)));
+        group->layer = m_ipcServer->AddLayer(group->layerPath);
+        if (!group->layer) {
+            return false;
+        }
+    }
+
+    auto prim = HdRprIpcDefinePrim(group->layer->GetStage()->GetRootLayer(), groupPath, _tokens->Xform);
+    auto transformAttr = HdRprIpcCreateTransformAttribute(prim);
+    HdRprIpcSetAttributeValue(transformAttr, group->transform);
+
+    m_ipcServer->OnLayerEdit(group->layerPath, group->layer);
+    return true;
+}
+
+void HdRprIpcTransformHierarchy::Commit() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& groupEntry : m_groups) {
+        auto& group = groupEntry.second;
+        if (!group.numDirtyChildren) {
+            continue;
+        }
+
+        GfMatrix4d groupTransform;
+        bool isGroupDirty = FindGroupTransform(group, &groupTransform);
+        if (isGroupDirty) {
+            auto prevTransform = group.transform;
+            group.transform = groupTransform;
+            if (!SendGroupTransform(groupEntry.first, &group)) {
+                group.transform = prevTransform;
+                isGroupDirty = false;
+            }
+        }
+
+        // Group prims are authored in world space. Without one, children stay in world space too,
+        // otherwise group prims of their ancestors would be applied on top of their world transforms
+        bool isWorldSpace = !group.layer;
+
+        double det;
+        auto groupInverse = group.transform.GetInverse(&det);
+
+        for (auto& childEntry : group.children) {
+            auto& state = childEntry.second;
+            if (!state.isDirty && !isGroupDirty) {
+                continue;
+            }
+            state.isDirty = false;
+
+            if (state.isSent && state.isWorldSpace == isWorldSpace &&
+                GfIsClose(state.localTransform * group.transform, state.worldTransform, kTransformTolerance)) {
+                continue;
+            }
+
+            state.localTransform = state.worldTransform * groupInverse;
+            state.isSent = true;
+            state.isWorldSpace = isWorldSpace;
+            // Children with the same id share the prim layer, authoring it once is enough
+            state.children.front()->SetLocalTransform(state.localTransform, isWorldSpace);
+        }
+        group.numDirtyChildren = 0;
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,99 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef HDRPR_TRANSFORM_HIERARCHY_H
+#define HDRPR_TRANSFORM_HIERARCHY_H
+
+#include "ipcServer.h"
+
+#include "pxr/base/gf/matrix4d.h"
+#include "pxr/usd/sdf/path.h"
+
+#include <mutex>
+#include <map>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Reconstructs parent transforms from the flattened world transforms Hydra provides.
+/// Prims are grouped by their parent path. When most prims of a group move
+/// by the same parent-space transform, only the group transform is sent,
+/// otherwise only prims whose local transform changed are updated.
+///
+/// Groups are shared by all render delegates of a session. Children of different
+/// delegates with the same id author the same shared prim layer, so the local
+/// transform is set on one of them and the prim leaves the hierarchy with the last one.
+class HdRprIpcTransformHierarchy {
+public:
+    class Child {
+    public:
+        virtual ~Child() = default;
+
+        /// Called from Commit with the transform relative to the parent group.
+        /// Until the group prim is authored \p transform is the world transform and \p isWorldSpace is set,
+        /// the child then has to reset the xform stack so that group prims of its ancestors do not apply to it
+        virtual void SetLocalTransform(GfMatrix4d const& transform, bool isWorldSpace) = 0;
+    };
+
+    HdRprIpcTransformHierarchy(HdRprIpcServer* ipcServer);
+    ~HdRprIpcTransformHierarchy();
+
+    HdRprIpcTransformHierarchy(const HdRprIpcTransformHierarchy&) = delete;
+    HdRprIpcTransformHierarchy& operator =(const HdRprIpcTransformHierarchy&) = delete;
+
+    /// Records new world transform of \p id, it is resolved on Commit
+    void SetWorldTransform(SdfPath const& id, GfMatrix4d const& transform, Child* child);
+
+    void RemoveChild(SdfPath const& id, Child* child);
+
+    bool HasChild(SdfPath const& id);
+
+    /// Resolves recorded world transforms into group and local transforms and sends group transforms
+    void Commit();
+
+private:
+    struct ChildState {
+        std::vector<Child*> children;
+        GfMatrix4d worldTransform;
+        GfMatrix4d localTransform;
+        bool isSent = false;
+        bool isWorldSpace = false;
+        bool isDirty = false;
+    };
+
+    struct Group {
+        std::map<SdfPath, ChildState> children;
+        size_t numDirtyChildren = 0;
+
+        GfMatrix4d transform = GfMatrix4d(1.0);
+        SdfPath layerPath;
+        RprIpcServer::Layer* layer = nullptr;
+    };
+
+    bool FindGroupTransform(Group const& group, GfMatrix4d* transform);
+    /// Returns false if the group prim could not be authored
+    bool SendGroupTransform(SdfPath const& groupPath, Group* group);
+
+private:
+    HdRprIpcServer* m_ipcServer;
+    SdfPath m_groupsPath;
+
+    std::mutex m_mutex;
+    std::map<SdfPath, Group> m_groups;
+    size_t m_groupCounter = 0;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_TRANSFORM_HIERARCHY_H